@@ -0,0 +1,634 @@
+#include "../TuningMaker/PitchSpace.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+  Fixed workloads which time the tuning engine and the code that builds scales for it, reported as JSON.
+  Run with --compare <baseline.json> to flag workloads which have become slower than a stored baseline.
+*/
+
+/*
+  Written to by microbenchmarks so that the compiler can't remove the work they time.
+*/
+static volatile uint64_t benchmarkSink;
+
+/*
+  The result of running one workload.
+*/
+struct BenchmarkResult
+{
+    std::string name;
+    /*
+      The shortest wall time of any repetition.
+    */
+    double wallSeconds{ 0 };
+    /*
+      The number of nodes of the trees of paths entered while tuning, or of operations for a
+      microbenchmark.
+    */
+    uint64_t nodes{ 0 };
+    double nodesPerSecond{ 0 };
+    /*
+      The peak resident set size of the process once the workload has run.
+    */
+    uint64_t peakResidentBytes{ 0 };
+    /*
+      For a workload which measures its accuracy, the greatest difference in cents of its tuning from the
+      exact tuning.
+    */
+    std::optional<double> centsError;
+};
+
+/*
+  A named workload. run() does the timed work and returns the number of nodes or operations it counts,
+  unless countNodes is set, in which case countNodes() returns them and is called before run() is timed.
+  If measureError is set, it returns the centsError of the tuning made by the last run(), and is called
+  after the timing. The centsError of each benchmark of an errorSeries must be no greater than that of the
+  one before it, as for tunings given ever longer to run. If check is set, it returns false if what the
+  last run() made is wrong, and is called after the timing.
+*/
+struct Benchmark
+{
+    std::string name;
+    std::function<uint64_t()> run;
+    std::function<uint64_t()> countNodes;
+    std::function<double()> measureError;
+    std::string errorSeries;
+    std::function<bool()> check;
+};
+
+/*
+  Returns the peak resident set size of the process in bytes.
+*/
+static uint64_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/*
+  Returns the number of nodes TuningEngine::logarithmic enters while tuning scale with settings, which is
+  the same tree of paths every exact engine traverses.
+*/
+static uint64_t countNodes(const Scale& scale, const TuningSettings& settings)
+{
+    uint64_t nodes{ 0 };
+
+    for (auto rootNote{ 0 }; rootNote != scale.size(); ++rootNote)
+        for (auto note{ 0 }; note != scale.size(); ++note)
+            if (note != rootNote)
+            {
+                auto traversal{ scale.makeTraversal(rootNote, note, settings.weightCutoff, settings.maxCentsError) };
+                traversal.run();
+
+                //every node is entered and left once
+                nodes += traversal.getStepCount() / 2;
+            }
+
+    return nodes;
+}
+
+/*
+  Returns a benchmark which tunes scale with settings. The nodes it visits are counted by countNodes(), so
+  only when the benchmark is run, and outside of its timing.
+*/
+static Benchmark makeTuningBenchmark(const std::string& name, const Scale& scale, const TuningSettings& settings)
+{
+    return { name, [=]()
+        {
+            scale.tuneScale(0, settings);
+
+            return uint64_t(0);
+        },
+        [=]() { return countNodes(scale, settings); }
+    };
+}
+
+/*
+  Returns a benchmark which tunes scale with settings, as makeTuningBenchmark() does, and measures how far
+  its tuning is from exactTuning.
+*/
+static Benchmark makeAccuracyBenchmark(const std::string& name, const Scale& scale, const TuningSettings& settings,
+                                       const std::vector<double>& exactTuning)
+{
+    auto benchmark{ makeTuningBenchmark(name, scale, settings) };
+    auto tuning{ std::make_shared<std::vector<double>>() };
+
+    benchmark.run = [=]()
+        {
+            *tuning = scale.tuneScale(0, settings);
+
+            return uint64_t(0);
+        };
+    benchmark.measureError = [=]() { return maxCentsDifference(*tuning, exactTuning); };
+
+    return benchmark;
+}
+
+/*
+  Returns a benchmark which tunes scale with Scale::tuneScaleUntil() given duration, and measures how far
+  its tuning is from exactTuning, as one of errorSeries.
+*/
+static Benchmark makeAnytimeBenchmark(const std::string& name, const Scale& scale, const TuningSettings& settings,
+                                      const std::chrono::milliseconds& duration, const std::vector<double>& exactTuning,
+                                      const std::string& errorSeries)
+{
+    auto tuning{ std::make_shared<std::vector<double>>() };
+
+    return { name, [=]()
+        {
+            *tuning = scale.tuneScaleUntil(0, settings, std::chrono::steady_clock::now() + duration).tuning;
+
+            return uint64_t(0);
+        },
+        nullptr,
+        [=]() { return maxCentsDifference(*tuning, exactTuning); },
+        errorSeries
+    };
+}
+
+/*
+  Returns a benchmark which tunes the keyboard of job in space with settings, and checks that every key it
+  maps is tuned to a frequency MIDI can give it.
+*/
+template<typename Relation>
+static Benchmark makeKeyboardBenchmark(const std::string& name, const PitchSpace<Relation>& space,
+                                       const KeyboardTuningJob& job, const TuningSettings& settings)
+{
+    auto tuning{ std::make_shared<std::optional<MidiTuning>>() };
+
+    return { name, [=, &space]()
+        {
+            *tuning = space.tuneKeyboard(job, settings);
+
+            return uint64_t(0);
+        },
+        nullptr,
+        nullptr,
+        "",
+        [=]()
+        {
+            if (!tuning->has_value())
+                return false;
+
+            return std::all_of(tuning->value().ratios.begin(), tuning->value().ratios.end(), [&](const double& ratio)
+                {
+                    return std::isnan(ratio) || KeyboardTuning::isFrequencyInMidiRange(job.rootFrequency * ratio);
+                });
+        }
+    };
+}
+
+/*
+  Returns the Scale of the named signiature of space extended to range, weighted as TuningMaker weights it.
+*/
+template<typename Relation>
+static Scale makeScale(const PitchSpace<Relation>& space, const std::string& signiatureName, const int& range)
+{
+    const auto relations{ space.makeRangedScaleRelations(signiatureName, range).value() };
+
+    if constexpr (std::is_same_v<Relation, Fraction>)
+        return Scale(IntervalPatternMakers::rangedScaleFractionsToIntervalsWithTenneyWeight(relations, 1), signiatureName);
+    else if constexpr (std::is_same_v<Relation, Monzo>)
+        return Scale(IntervalPatternMakers::rangedScaleMonzosToIntervalsWithTenneyWeight(relations, 1), signiatureName);
+    else
+        return Scale(IntervalPatternMakers::rangedScaleLongDoubleToIntervalsWithUniformWeight(relations), signiatureName);
+}
+
+/*
+  Returns every workload.
+*/
+static std::vector<Benchmark> makeBenchmarks(ThreadPool& threadPool)
+{
+    static constexpr long double defaultWeightCutoff{ 0.0001L };
+
+    TuningSettings settings;
+    settings.weightCutoff = defaultWeightCutoff;
+    settings.engine = TuningEngine::logarithmic;
+    settings.threadPool = &threadPool;
+    settings.silent = true;
+
+    const auto& twelveEDO{ PitchSpaces::fractional().at("12edo") };
+    const auto& twentytwoEDO{ PitchSpaces::fractional().at("22edo") };
+
+    std::vector<Benchmark> benchmarks;
+
+    for (const auto& signiatureName : { "ionian", "major_pentatonic" })
+        for (auto range{ 6 }; range <= 14; ++range)
+            benchmarks.push_back(makeTuningBenchmark("tune/12edo/" + std::string(signiatureName) + "/" + std::to_string(range),
+                                                     makeScale(twelveEDO, signiatureName, range), settings));
+
+    benchmarks.push_back(makeTuningBenchmark("tune/22edo/orwell9/9", makeScale(twentytwoEDO, "orwell9", 9), settings));
+
+    //the same pitch space as 12edo with decimal relations, which are weighted uniformly
+    std::vector<long double> decimalTable;
+    for (const auto& relation : twelveEDO.getTable())
+        decimalTable.push_back(relation.toLongDouble());
+
+    PitchSpace<long double> decimalTwelveEDO(decimalTable);
+    decimalTwelveEDO.addSigniature("ionian", twelveEDO.getSigniature("ionian").value());
+
+    const auto fractionalTable{ twelveEDO.getTable() };
+    const std::vector<Monzo> monzoTable(fractionalTable.begin(), fractionalTable.end());
+
+    PitchSpace<Monzo> monzoTwelveEDO(monzoTable);
+    monzoTwelveEDO.addSigniature("ionian", twelveEDO.getSigniature("ionian").value());
+
+    benchmarks.push_back(makeTuningBenchmark("tune/fractional/12edo/ionian/10", makeScale(twelveEDO, "ionian", 10),
+                                             settings));
+    benchmarks.push_back(makeTuningBenchmark("tune/decimal/12edo/ionian/10", makeScale(decimalTwelveEDO, "ionian", 10),
+                                             settings));
+    benchmarks.push_back(makeTuningBenchmark("tune/monzo/12edo/ionian/10", makeScale(monzoTwelveEDO, "ionian", 10),
+                                             settings));
+
+    for (const auto& weightCutoff : { 0.01L, 0.001L, 0.0001L, 0.00001L })
+    {
+        auto cutoffSettings{ settings };
+        cutoffSettings.weightCutoff = weightCutoff;
+
+        std::ostringstream name;
+        name << "cutoff/12edo/ionian/12/" << weightCutoff;
+
+        benchmarks.push_back(makeTuningBenchmark(name.str(), makeScale(twelveEDO, "ionian", 12), cutoffSettings));
+    }
+
+    //the nodes each way of pruning needs to reach an error, so that pruning by a guaranteed error can be
+    //compared against the weight cutoff which happens to reach the same error
+    const auto accuracyScale{ makeScale(twelveEDO, "ionian", 11) };
+
+    auto exactSettings{ settings };
+    exactSettings.engine = TuningEngine::exactSubsets;
+    exactSettings.weightCutoff = 0;
+
+    const auto exactTuning{ accuracyScale.tuneScale(0, exactSettings) };
+
+    for (const auto& weightCutoff : { 0.001L, 0.0001L, 0.00001L })
+    {
+        auto cutoffSettings{ settings };
+        cutoffSettings.weightCutoff = weightCutoff;
+
+        std::ostringstream name;
+        name << "accuracy/12edo/ionian/11/cutoff/" << weightCutoff;
+
+        benchmarks.push_back(makeAccuracyBenchmark(name.str(), accuracyScale, cutoffSettings, exactTuning));
+    }
+
+    for (const auto& maxCentsError : { 10.0, 1.0 })
+    {
+        auto boundedSettings{ settings };
+        boundedSettings.maxCentsError = maxCentsError;
+
+        std::ostringstream name;
+        name << "accuracy/12edo/ionian/11/maxcents/" << maxCentsError;
+
+        benchmarks.push_back(makeAccuracyBenchmark(name.str(), accuracyScale, boundedSettings, exactTuning));
+    }
+
+    //the error of a tuning given until a deadline, which must not grow as the deadline grows
+    auto anytimeSettings{ settings };
+    anytimeSettings.weightCutoff = 0;
+
+    for (const auto& milliseconds : { 10, 100, 1000 })
+        benchmarks.push_back(makeAnytimeBenchmark("anytime/12edo/ionian/11/" + std::to_string(milliseconds) + "ms",
+                                                  accuracyScale, anytimeSettings,
+                                                  std::chrono::milliseconds(milliseconds), exactTuning,
+                                                  "anytime/12edo/ionian/11"));
+
+    //a scale with fewer notes per octave than 12edo, whose keyboard spreads past the notes MIDI can tune
+    KeyboardTuningJob keyboardJob;
+    keyboardJob.signiatureName = "ionian";
+    keyboardJob.weightCutoff = defaultWeightCutoff;
+
+    benchmarks.push_back(makeKeyboardBenchmark("keyboard/12edo/ionian", twelveEDO, keyboardJob, settings));
+
+    benchmarks.push_back({ "micro/Fraction/arithmetic", []()
+        {
+            static constexpr uint64_t operationCount{ 2000000 };
+
+            Fraction product;
+            for (uint64_t operation{ 0 }; operation != operationCount; ++operation)
+            {
+                product = product * Fraction(3 + operation % 5, 2 + operation % 5);
+                product = product.reciporical() * Fraction(2);
+
+                if (product.getNumerator() > 1000000 || product.getDenominator() > 1000000)
+                    product = Fraction();
+            }
+
+            benchmarkSink = product.getNumerator();
+            return operationCount * 2;
+        }
+    });
+
+    benchmarks.push_back({ "micro/Monzo/arithmetic", []()
+        {
+            static constexpr uint64_t operationCount{ 2000000 };
+
+            Monzo product;
+            for (uint64_t operation{ 0 }; operation != operationCount; ++operation)
+            {
+                product = product * Monzo(3 + operation % 5, 2 + operation % 5);
+                product = product.reciporical() * Monzo(2);
+            }
+
+            benchmarkSink = product.getExponent(0);
+            return operationCount * 2;
+        }
+    });
+
+    benchmarks.push_back({ "micro/PitchSpace/getRelation", [&twelveEDO]()
+        {
+            static constexpr int noteCount{ 128 };
+
+            uint64_t numeratorSum{ 0 };
+            for (auto repetition{ 0 }; repetition != 100; ++repetition)
+                for (auto noteTo{ 0 }; noteTo != noteCount; ++noteTo)
+                    for (auto noteFrom{ 0 }; noteFrom != noteCount; ++noteFrom)
+                        numeratorSum += twelveEDO.getRelation(noteTo % 48, noteFrom % 48).getNumerator();
+
+            benchmarkSink = numeratorSum;
+            return (uint64_t)100 * noteCount * noteCount;
+        }
+    });
+
+    benchmarks.push_back({ "micro/PitchSpace/makeRangedScaleRelations", [&twelveEDO]()
+        {
+            static constexpr int repetitionCount{ 2000 };
+
+            size_t rowCount{ 0 };
+            for (auto repetition{ 0 }; repetition != repetitionCount; ++repetition)
+                rowCount += twelveEDO.makeRangedScaleRelations("ionian", 14).value().size();
+
+            benchmarkSink = rowCount;
+            return (uint64_t)repetitionCount;
+        }
+    });
+
+    return benchmarks;
+}
+
+/*
+  Returns the value of the JSON number following "key": in line, if there is one.
+*/
+static std::optional<double> readNumber(const std::string& line, const std::string& key)
+{
+    const auto position{ line.find("\"" + key + "\":") };
+
+    if (position == std::string::npos)
+        return std::nullopt;
+
+    return std::stod(line.substr(position + key.size() + 3));
+}
+
+/*
+  Returns the value of the JSON string following "key": in line, if there is one.
+*/
+static std::optional<std::string> readString(const std::string& line, const std::string& key)
+{
+    const auto position{ line.find("\"" + key + "\": \"") };
+
+    if (position == std::string::npos)
+        return std::nullopt;
+
+    const auto start{ position + key.size() + 5 };
+
+    return line.substr(start, line.find('"', start) - start);
+}
+
+/*
+  Reads the wall time of every benchmark in a file written by writeResults().
+*/
+static std::map<std::string, double> readBaseline(std::istream& input)
+{
+    std::map<std::string, double> baseline;
+
+    for (std::string line; std::getline(input, line);)
+    {
+        const auto name{ readString(line, "name") };
+        const auto wallSeconds{ readNumber(line, "wall_seconds") };
+
+        if (name.has_value() && wallSeconds.has_value())
+            baseline[name.value()] = wallSeconds.value();
+    }
+
+    return baseline;
+}
+
+/*
+  Writes results as JSON, one benchmark to a line so that readBaseline() can read them back.
+*/
+static void writeResults(std::ostream& output, const std::vector<BenchmarkResult>& results)
+{
+    output << "{\n  \"benchmarks\": [\n";
+
+    for (auto resultIndex{ 0 }; resultIndex != results.size(); ++resultIndex)
+    {
+        const auto& result{ results[resultIndex] };
+
+        output << "    { \"name\": \"" << result.name << "\", \"wall_seconds\": " << result.wallSeconds
+               << ", \"nodes\": " << result.nodes << ", \"nodes_per_second\": " << result.nodesPerSecond
+               << ", \"peak_rss_bytes\": " << result.peakResidentBytes;
+
+        if (result.centsError.has_value())
+            output << ", \"cents_error\": " << result.centsError.value();
+
+        output << " }" << (resultIndex + 1 != results.size() ? "," : "") << "\n";
+    }
+
+    output << "  ]\n}" << std::endl;
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: Benchmarks [--filter <text>] [--repetitions <n>] [--threads <n>] [--output <file>]\n"
+              << "                  [--compare <baseline.json>] [--tolerance <fraction>]\n"
+              << "Runs every benchmark whose name contains the filter text and writes the results as JSON.\n"
+              << "With --compare, exits with 1 if any benchmark's wall time exceeds the baseline's by more than\n"
+              << "the tolerance (default 0.25) and by more than a millisecond. Exits with 1 too if the error of\n"
+              << "a tuning given longer to run is greater than that of one given less, or if a benchmark's\n"
+              << "check of what it made fails." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter, outputPath, baselinePath;
+    auto repetitionCount{ 3 };
+    auto threadCount{ std::max(1u, std::thread::hardware_concurrency()) };
+    auto tolerance{ 0.25 };
+
+    for (auto argument{ 1 }; argument < argc; ++argument)
+    {
+        const std::string option{ argv[argument] };
+
+        if (argument + 1 == argc)
+        {
+            printUsage();
+
+            return 2;
+        }
+
+        const std::string value{ argv[++argument] };
+
+        if (option == "--filter")
+            filter = value;
+        else if (option == "--repetitions")
+            repetitionCount = std::max(1, std::stoi(value));
+        else if (option == "--threads")
+            threadCount = std::stoul(value);
+        else if (option == "--output")
+            outputPath = value;
+        else if (option == "--compare")
+            baselinePath = value;
+        else if (option == "--tolerance")
+            tolerance = std::stod(value);
+        else
+        {
+            printUsage();
+
+            return 2;
+        }
+    }
+
+    ThreadPool threadPool(threadCount);
+
+    std::vector<BenchmarkResult> results;
+    //the centsError of the last benchmark run of each errorSeries, and the number of times one grew
+    std::map<std::string, double> seriesErrors;
+    auto errorGrowthCount{ 0 };
+    auto failedCheckCount{ 0 };
+
+    for (auto& benchmark : makeBenchmarks(threadPool))
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+            continue;
+
+        BenchmarkResult result;
+        result.name = benchmark.name;
+        result.wallSeconds = std::numeric_limits<double>::max();
+
+        if (benchmark.countNodes)
+            result.nodes = benchmark.countNodes();
+
+        for (auto repetition{ 0 }; repetition != repetitionCount; ++repetition)
+        {
+            const auto start{ std::chrono::steady_clock::now() };
+            const auto nodes{ benchmark.run() };
+            const auto wallSeconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+            if (!benchmark.countNodes)
+                result.nodes = nodes;
+
+            result.wallSeconds = std::min(result.wallSeconds, wallSeconds);
+        }
+
+        result.nodesPerSecond = result.wallSeconds > 0 ? result.nodes / result.wallSeconds : 0;
+        result.peakResidentBytes = peakResidentBytes();
+
+        if (benchmark.measureError)
+            result.centsError = benchmark.measureError();
+
+        std::cerr << result.name << " " << result.wallSeconds << "s";
+
+        if (result.centsError.has_value())
+            std::cerr << " " << result.centsError.value() << " cents";
+
+        std::cerr << std::endl;
+
+        if (!benchmark.errorSeries.empty() && result.centsError.has_value())
+        {
+            const auto seriesError{ seriesErrors.find(benchmark.errorSeries) };
+
+            if (seriesError != seriesErrors.end() && result.centsError.value() > seriesError->second)
+            {
+                std::cerr << "ERROR GREW " << result.name << " " << seriesError->second << " cents -> "
+                          << result.centsError.value() << " cents" << std::endl;
+                ++errorGrowthCount;
+            }
+
+            seriesErrors[benchmark.errorSeries] = result.centsError.value();
+        }
+
+        if (benchmark.check && !benchmark.check())
+        {
+            std::cerr << "CHECK FAILED " << result.name << std::endl;
+            ++failedCheckCount;
+        }
+
+        results.push_back(result);
+    }
+
+    if (outputPath.empty())
+        writeResults(std::cout, results);
+    else
+    {
+        std::ofstream output(outputPath);
+        writeResults(output, results);
+    }
+
+    if (baselinePath.empty())
+        return errorGrowthCount == 0 && failedCheckCount == 0 ? 0 : 1;
+
+    std::ifstream baselineFile(baselinePath);
+
+    if (!baselineFile)
+    {
+        std::cerr << "Can't read baseline " << baselinePath << std::endl;
+
+        return 2;
+    }
+
+    const auto baseline{ readBaseline(baselineFile) };
+    auto regressionCount{ 0 };
+
+    for (const auto& result : results)
+    {
+        const auto baselineResult{ baseline.find(result.name) };
+
+        if (baselineResult == baseline.end())
+        {
+            std::cerr << "NEW        " << result.name << std::endl;
+
+            continue;
+        }
+
+        const auto ratio{ result.wallSeconds / baselineResult->second };
+        //differences of under a millisecond are timer and scheduler noise
+        const auto isRegression{ ratio > 1 + tolerance && result.wallSeconds - baselineResult->second > 0.001 };
+
+        if (isRegression)
+            ++regressionCount;
+
+        std::cerr << (isRegression ? "REGRESSION " : "ok         ") << result.name << " "
+                  << baselineResult->second << "s -> " << result.wallSeconds << "s (x" << ratio << ")" << std::endl;
+    }
+
+    std::cerr << regressionCount << " regression(s)" << std::endl;
+
+    return regressionCount == 0 && errorGrowthCount == 0 && failedCheckCount == 0 ? 0 : 1;
+}
\ No newline at end of file
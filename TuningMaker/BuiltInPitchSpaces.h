@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <numeric>
+#include <string_view>
+
+/*
+  The standard pitch spaces and their named scales, as tables calculated entirely at compile time. The
+  relations of each table are cancelled and sorted before the program starts, and PitchSpaces::fractional()
+  builds its pitch spaces from these tables the first time it is called.
+*/
+namespace BuiltInPitchSpaces
+{
+    /*
+      The greatest number of notes in a built-in scale signiature.
+    */
+    static constexpr size_t maxSigniatureSize{ 24 };
+
+    /*
+      A relation of a pitch space, cancelled.
+    */
+    struct Relation
+    {
+        int numerator;
+        int denominator;
+    };
+
+    /*
+      A named scale signiature, whose first noteCount notes are the indecies of the notes of the pitch space
+      in the scale.
+    */
+    struct Signiature
+    {
+        std::string_view name;
+        std::array<int, maxSigniatureSize> notes;
+        size_t noteCount;
+    };
+
+    /*
+      A pitch space of RelationCount relations with SigniatureCount named scales.
+    */
+    template<size_t RelationCount, size_t SigniatureCount>
+    struct Table
+    {
+        std::string_view name;
+        std::array<Relation, RelationCount> relations;
+        std::array<Signiature, SigniatureCount> signiatures;
+    };
+
+    /*
+      Returns fractions, each given as { numerator, denominator }, cancelled and sorted in increasing size.
+    */
+    template<size_t RelationCount>
+    constexpr std::array<Relation, RelationCount> makeRelations(const int (&fractions)[RelationCount][2])
+    {
+        std::array<Relation, RelationCount> relations{};
+
+        for (size_t relationIndex{ 0 }; relationIndex != RelationCount; ++relationIndex)
+        {
+            const auto numerator{ fractions[relationIndex][0] };
+            const auto denominator{ fractions[relationIndex][1] };
+            const auto divisor{ std::gcd(numerator, denominator) };
+
+            relations[relationIndex] = { numerator / divisor, denominator / divisor };
+        }
+
+        std::sort(relations.begin(), relations.end(), [](const Relation& relation, const Relation& otherRelation)
+            {
+                return (long long)relation.numerator * otherRelation.denominator
+                    < (long long)otherRelation.numerator * relation.denominator;
+            });
+
+        return relations;
+    }
+
+    /*
+      Returns the signiature of the notes named name.
+    */
+    constexpr Signiature makeSigniature(const std::string_view& name, const std::initializer_list<int>& notes)
+    {
+        Signiature signiature{ name, {}, notes.size() };
+        std::copy(notes.begin(), notes.end(), signiature.notes.begin());
+
+        return signiature;
+    }
+
+    inline constexpr Table<7, 2> sevenEDO
+    {
+        "7edo",
+        makeRelations({ { 10, 9 }, { 11, 9 }, { 4, 3 }, { 3, 2 }, { 13, 8 }, { 9, 5 }, { 2, 1 } }),
+        {
+            makeSigniature("neutral_pentatonic_A", { 0, 1, 3, 4, 6 }),
+            makeSigniature("neutral_pentatonic_B", { 0, 2, 3, 5, 6 })
+        }
+    };
+
+    inline constexpr Table<12, 9> twelveEDO
+    {
+        "12edo",
+        makeRelations({ { 17, 16 }, { 9, 8 }, { 6, 5 }, { 5, 4 }, { 4, 3 }, { 7, 5 }, { 3, 2 }, { 8, 5 }, { 5, 3 },
+                        { 9, 5 }, { 15, 8 }, { 2, 1 } }),
+        {
+            makeSigniature("major_pentatonic", { 0, 2, 4, 7, 9 }),
+            makeSigniature("minor_pentatonic", { 0, 3, 4, 7, 10 }),
+            makeSigniature("ionian", { 0, 2, 4, 5, 7, 9, 11 }),
+            makeSigniature("dorian", { 0, 2, 3, 5, 7, 9, 10 }),
+            makeSigniature("phrygian", { 0, 1, 3, 5, 7, 8, 10 }),
+            makeSigniature("lydian", { 0, 2, 4, 6, 7, 9, 11 }),
+            makeSigniature("myxolydian", { 0, 2, 4, 5, 7, 9, 10 }),
+            makeSigniature("aolian", { 0, 2, 3, 5, 7, 8, 10 }),
+            makeSigniature("locrian", { 0, 1, 3, 5, 6, 8, 10 })
+        }
+    };
+
+    inline constexpr Table<17, 0> seventeenEDO
+    {
+        "17edo",
+        makeRelations({ { 24, 23 }, { 12, 11 }, { 8, 7 }, { 7, 6 }, { 11, 9 }, { 9, 7 }, { 4, 3 }, { 11, 8 },
+                        { 13, 9 }, { 3, 2 }, { 11, 7 }, { 13, 8 }, { 12, 7 }, { 7, 4 }, { 11, 6 }, { 23, 12 },
+                        { 2, 1 } }),
+        {}
+    };
+
+    inline constexpr Table<23, 1> twentytwoEDO
+    {
+        "22edo",
+        makeRelations({ { 32, 31 }, { 16, 15 }, { 8, 7 }, { 11, 10 }, { 9, 8 }, { 7, 6 }, { 6, 5 }, { 5, 4 },
+                        { 9, 7 }, { 4, 3 }, { 11, 8 }, { 7, 5 }, { 16, 11 }, { 3, 2 }, { 11, 7 }, { 8, 5 },
+                        { 5, 3 }, { 12, 7 }, { 7, 4 }, { 9, 5 }, { 15, 8 }, { 31, 16 }, { 2, 1 } }),
+        {
+            makeSigniature("orwell9", { 0, 3, 5, 8, 10, 13, 15, 18, 20 })
+        }
+    };
+
+    inline constexpr Table<15, 0> fifteenEDO
+    {
+        "15edo",
+        makeRelations({ { 21, 20 }, { 11, 10 }, { 8, 7 }, { 6, 5 }, { 5, 4 }, { 4, 3 }, { 11, 8 }, { 16, 11 },
+                        { 3, 2 }, { 8, 5 }, { 5, 3 }, { 7, 4 }, { 11, 6 }, { 21, 11 }, { 2, 1 } }),
+        {}
+    };
+
+    static_assert(twelveEDO.relations.front().numerator == 17 && twelveEDO.relations.back().numerator == 2);
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "MidiTuning.h"
+#include <fstream>
+#include <numbers>
+
+/*
+  The frequency of MIDI key 0 in 12edo with A4 = 440Hz, which the cents of an AnaMark tuning are relative to.
+*/
+static constexpr double midiKeyZeroFrequency{ 8.1757989156437073336 };
+
+/*
+  The fractions of a semitone of 12edo in a MIDI Tuning Standard bulk dump, and the most semitones above
+  MIDI key 0 it can tune a key to, as 7F 7F 7F is reserved for no change.
+*/
+static constexpr int bulkDumpFractionsPerSemitone{ 16384 };
+static constexpr double maxBulkDumpSemitones{ 127 + (bulkDumpFractionsPerSemitone - 2.0) / bulkDumpFractionsPerSemitone };
+
+/*
+  Returns a divided by b rounded towards negative infinity.
+*/
+static int floorDivide(const int& a, const int& b)
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/*
+  Returns a modulo b in [0, b).
+*/
+static int floorModulo(const int& a, const int& b)
+{
+    return a - floorDivide(a, b) * b;
+}
+
+std::optional<MidiTuning> KeyboardTuning::extendTuning(const std::vector<double>& windowTuning,
+                                                       const std::vector<int>& signiature, const int& pitchSpaceSize,
+                                                       const double& periodRatio, const KeyboardTuningJob& job,
+                                                       const std::string& name)
+{
+    const int notesPerPeriod(signiature.size());
+    const int windowSize(windowTuning.size());
+
+    if (notesPerPeriod == 0 || windowSize < notesPerPeriod + 1 || (windowSize - 1) % notesPerPeriod != 0
+        || job.rootDegree < 0 || job.rootDegree >= notesPerPeriod || job.rootKey < 0 || job.rootKey >= maxMidiNotes
+        || !(periodRatio > 1) || !isFrequencyInMidiRange(job.rootFrequency))
+        return std::nullopt;
+
+    const auto logPeriod{ std::log2(periodRatio) };
+
+    //the log tuning of each degree in the first period, blended from every period of the window
+    std::vector<double> degreeLogTunings(notesPerPeriod, 0);
+    std::vector<double> degreeWeightSums(notesPerPeriod, 0);
+
+    for (auto note{ 0 }; note != windowSize; ++note)
+    {
+        if (!(windowTuning[note] > 0))
+            return std::nullopt;
+
+        const auto weight{ std::pow(std::sin(std::numbers::pi * (note + 1) / (windowSize + 1)), 2) };
+        const auto degree{ note % notesPerPeriod };
+
+        degreeLogTunings[degree] += weight * (std::log2(windowTuning[note] / windowTuning[0])
+                                              - (note / notesPerPeriod) * logPeriod);
+        degreeWeightSums[degree] += weight;
+    }
+
+    for (auto degree{ 0 }; degree != notesPerPeriod; ++degree)
+        degreeLogTunings[degree] /= degreeWeightSums[degree];
+
+    //the log tuning of the note offset notes of the scale above the root
+    auto logTuningFromRoot{ [&](const int& offset)
+        {
+            const auto note{ job.rootDegree + offset };
+
+            return degreeLogTunings[floorModulo(note, notesPerPeriod)] + floorDivide(note, notesPerPeriod) * logPeriod
+                - degreeLogTunings[job.rootDegree];
+        }
+    };
+
+    MidiTuning tuning;
+    tuning.name = name;
+    tuning.rootKey = job.rootKey;
+    tuning.rootFrequency = job.rootFrequency;
+
+    for (auto degree{ 1 }; degree <= notesPerPeriod; ++degree)
+        tuning.periodCents.push_back(1200 * logTuningFromRoot(degree));
+
+    if (!job.withDummyNotes)
+    {
+        for (auto key{ 0 }; key != maxMidiNotes; ++key)
+            tuning.ratios[key] = std::exp2(logTuningFromRoot(key - job.rootKey));
+
+        for (auto degree{ 0 }; degree != notesPerPeriod; ++degree)
+            tuning.keyboardMapping.push_back(degree);
+    }
+    else
+    {
+        //each key plays one note of the pitch space, which is a note of the scale if it is in signiature
+        const auto rootStep{ signiature[job.rootDegree] };
+
+        auto offsetOfStep{ [&](const int& stepFromRoot) -> std::optional<int>
+            {
+                const auto step{ rootStep + stepFromRoot };
+                const auto position{ std::find(signiature.begin(), signiature.end(), floorModulo(step, pitchSpaceSize)) };
+
+                if (position == signiature.end())
+                    return std::nullopt;
+
+                return (int)(position - signiature.begin()) + floorDivide(step, pitchSpaceSize) * notesPerPeriod - job.rootDegree;
+            }
+        };
+
+        for (auto key{ 0 }; key != maxMidiNotes; ++key)
+        {
+            const auto offset{ offsetOfStep(key - job.rootKey) };
+            tuning.ratios[key] = offset.has_value() ? std::exp2(logTuningFromRoot(offset.value()))
+                                                    : std::numeric_limits<double>::quiet_NaN();
+        }
+
+        for (auto step{ 0 }; step != pitchSpaceSize; ++step)
+            tuning.keyboardMapping.push_back(offsetOfStep(step).value_or(-1));
+    }
+
+    //a scale with fewer notes than 12edo per octave spreads past the notes MIDI can tune well before the
+    //ends of the keyboard, so the keys beyond them play nothing rather than the nearest note it can tune
+    for (auto& ratio : tuning.ratios)
+        if (!isFrequencyInMidiRange(job.rootFrequency * ratio))
+            ratio = std::numeric_limits<double>::quiet_NaN();
+
+    return tuning;
+}
+
+bool KeyboardTuning::isFrequencyInMidiRange(const double& frequency)
+{
+    const auto semitones{ centsFromRatio(frequency / midiKeyZeroFrequency) / 100 };
+
+    return semitones >= 0 && semitones <= maxBulkDumpSemitones;
+}
+
+/*
+  Writes tuning as a Scala .scl scale.
+*/
+static void writeScala(std::ostream& output, const MidiTuning& tuning, const std::string& fileName)
+{
+    output << "! " << fileName << "\n!\n" << tuning.name << "\n " << tuning.periodCents.size() << "\n!\n";
+
+    for (const auto& cents : tuning.periodCents)
+        output << " " << std::fixed << std::setprecision(6) << cents << "\n";
+}
+
+/*
+  Writes tuning as a Scala .kbm keyboard mapping, which places the root of the .scl scale on rootKey. Keys
+  outside of the first and last which are mapped aren't retuned.
+*/
+static void writeKeyboardMapping(std::ostream& output, const MidiTuning& tuning, const std::string& fileName,
+                                 const std::array<bool, maxMidiNotes>& isKeyMapped)
+{
+    const auto firstKey{ std::find(isKeyMapped.begin(), isKeyMapped.end(), true) - isKeyMapped.begin() };
+    const auto lastKey{ std::find(isKeyMapped.rbegin(), isKeyMapped.rend(), true).base() - isKeyMapped.begin() - 1 };
+
+    output << "! " << fileName << "\n"
+           << "! Size of map:\n" << tuning.keyboardMapping.size() << "\n"
+           << "! First MIDI note number to retune:\n" << firstKey << "\n"
+           << "! Last MIDI note number to retune:\n" << lastKey << "\n"
+           << "! Middle note where the first entry of the mapping is mapped to:\n" << tuning.rootKey << "\n"
+           << "! Reference note for which frequency is given:\n" << tuning.rootKey << "\n"
+           << "! Frequency to tune the above note to:\n" << std::fixed << std::setprecision(6) << tuning.rootFrequency << "\n"
+           << "! Scale degree to consider as formal octave:\n" << tuning.periodCents.size() << "\n"
+           << "! Mapping.\n";
+
+    for (const auto& degree : tuning.keyboardMapping)
+    {
+        if (degree < 0)
+            output << "x\n";
+        else
+            output << degree << "\n";
+    }
+}
+
+/*
+  Writes tuning as an AnaMark .tun file. Keys which aren't mapped keep their 12edo tuning.
+*/
+static void writeAnaMark(std::ostream& output, const MidiTuning& tuning, const std::array<double, maxMidiNotes>& keyCents)
+{
+    output << "[Scale Begin]\n"
+           << "Format= \"AnaMark-TUN\"\n"
+           << "FormatVersion= 200\n"
+           << "FormatSpecs= \"http://www.mark-henning.de/eternity/tuningspecs.html\"\n\n"
+           << "[Info]\n"
+           << "Name= \"" << tuning.name << "\"\n\n"
+           << "[Tuning]\n";
+
+    for (auto key{ 0 }; key != maxMidiNotes; ++key)
+        output << "note " << key << "= " << std::lround(keyCents[key]) << "\n";
+
+    output << "\n[Exact Tuning]\n"
+           << "BaseFreq= " << std::fixed << std::setprecision(10) << midiKeyZeroFrequency << "\n";
+
+    for (auto key{ 0 }; key != maxMidiNotes; ++key)
+        output << "note " << key << "= " << std::fixed << std::setprecision(6) << keyCents[key] << "\n";
+
+    output << "\n[Scale End]\n";
+}
+
+/*
+  Writes tuning as a MIDI Tuning Standard bulk tuning dump. Keys which aren't mapped are left unchanged.
+*/
+static void writeBulkDump(std::ostream& output, const MidiTuning& tuning, const std::array<double, maxMidiNotes>& keyCents,
+                          const std::array<bool, maxMidiNotes>& isKeyMapped)
+{
+    std::vector<unsigned char> message{ 0xF0, 0x7E, 0x7F, 0x08, 0x01, 0x00 };
+
+    //a 16 character name, padded with spaces
+    for (auto character{ 0 }; character != 16; ++character)
+        message.push_back(character < tuning.name.size() ? tuning.name[character] & 0x7F : ' ');
+
+    for (auto key{ 0 }; key != maxMidiNotes; ++key)
+    {
+        if (!isKeyMapped[key])
+        {
+            message.insert(message.end(), { 0x7F, 0x7F, 0x7F });
+
+            continue;
+        }
+
+        //a semitone of 12edo and a fraction of it in 14 bits, which for a mapped key is never the 7F 7F 7F
+        //reserved for no change
+        const auto semitones{ keyCents[key] / 100 };
+        auto semitone{ (int)semitones };
+        auto fraction{ (int)std::lround((semitones - semitone) * bulkDumpFractionsPerSemitone) };
+
+        if (fraction == bulkDumpFractionsPerSemitone)
+        {
+            ++semitone;
+            fraction = 0;
+        }
+
+        message.insert(message.end(), { (unsigned char)semitone, (unsigned char)(fraction >> 7),
+                                        (unsigned char)(fraction & 0x7F) });
+    }
+
+    unsigned char checksum{ 0 };
+    for (auto byte{ std::next(message.begin()) }; byte != message.end(); ++byte)
+        checksum ^= *byte;
+
+    message.push_back(checksum & 0x7F);
+    message.push_back(0xF7);
+
+    output.write(reinterpret_cast<const char*>(message.data()), message.size());
+}
+
+bool KeyboardTuning::writeFiles(const MidiTuning& tuning, const std::filesystem::path& basePath)
+{
+    //the cents of every key above MIDI key 0 in 12edo, calculated once for every format, and whether the key
+    //plays a note of the scale which MIDI can tune
+    std::array<double, maxMidiNotes> keyCents;
+    std::array<bool, maxMidiNotes> isKeyMapped;
+
+    const auto rootCents{ centsFromRatio(tuning.rootFrequency / midiKeyZeroFrequency) };
+
+    for (auto key{ 0 }; key != maxMidiNotes; ++key)
+    {
+        isKeyMapped[key] = isFrequencyInMidiRange(tuning.rootFrequency * tuning.ratios[key]);
+        keyCents[key] = isKeyMapped[key] ? rootCents + centsFromRatio(tuning.ratios[key]) : 100.0 * key;
+    }
+
+    auto pathWithExtension{ [&](const char* extension)
+        {
+            return std::filesystem::path(basePath).concat(extension);
+        }
+    };
+
+    std::ofstream scala(pathWithExtension(".scl"));
+    writeScala(scala, tuning, pathWithExtension(".scl").filename().string());
+
+    std::ofstream keyboardMapping(pathWithExtension(".kbm"));
+    writeKeyboardMapping(keyboardMapping, tuning, pathWithExtension(".kbm").filename().string(), isKeyMapped);
+
+    std::ofstream anaMark(pathWithExtension(".tun"));
+    writeAnaMark(anaMark, tuning, keyCents);
+
+    std::ofstream bulkDump(pathWithExtension(".syx"), std::ios::binary);
+    writeBulkDump(bulkDump, tuning, keyCents, isKeyMapped);
+
+    return scala.good() && keyboardMapping.good() && anaMark.good() && bulkDump.good();
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include "Utilities.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+
+/*
+  A tuning of a whole MIDI keyboard made by KeyboardTuning::extendTuning() from a tuning of a few periods of
+  a scale, which is much faster than tuning a scale of maxMidiNotes notes and repeats exactly every period.
+*/
+struct MidiTuning
+{
+    std::string name;
+    /*
+      The ratio of each key to rootKey, or NaN for keys which play no note of the scale, or whose note is
+      outside of the range of KeyboardTuning::isFrequencyInMidiRange().
+    */
+    std::array<double, maxMidiNotes> ratios;
+    int rootKey;
+    double rootFrequency;
+    /*
+      The size in cents above the root of every degree of one period of the scale, ending with the period
+      itself, as they are listed in a Scala .scl file.
+    */
+    std::vector<double> periodCents;
+    /*
+      For each key of one period of the keyboard from rootKey, the degree of the scale it plays, or -1 if it
+      plays none, as they are listed in a Scala .kbm file.
+    */
+    std::vector<int> keyboardMapping;
+};
+
+/*
+  The parameters of a tuning of a whole MIDI keyboard by PitchSpace::tuneKeyboard().
+*/
+struct KeyboardTuningJob
+{
+    std::string signiatureName;
+    /*
+      The number of periods of the scale which are tuned. The tuning of each degree of the scale is blended
+      from every period, so more periods give smoother seams at the cost of a much longer tuning.
+    */
+    int periods{ 2 };
+    long double entropyCurve{ 1 };
+    long double weightCutoff{ 0 };
+    /*
+      The degree of the scale played by rootKey.
+    */
+    int rootDegree{ 0 };
+    /*
+      If true, every key plays one note of the pitch space, and keys for notes not in the scale play nothing.
+      Otherwise every key plays one note of the scale.
+    */
+    bool withDummyNotes{ false };
+    int rootKey{ 60 };
+    double rootFrequency{ 261.6255653005986 };
+};
+
+namespace KeyboardTuning
+{
+    /*
+      Extends windowTuning, the tuning of the notes of a scale from degree 0 of signiature up to and
+      including the same degree some number of periods later, across every MIDI key. Each degree's
+      tuning is the weighted geometric mean of its tuning in every period of the window, each normalised
+      into the first period with periodRatio, weighted by a window which falls to 0 at both ends so that
+      notes at the edges of the tuned range, which have the fewest neighbours, count least. Keys whose note
+      is outside of the range of isFrequencyInMidiRange() play nothing. Returns std::nullopt if the window
+      doesn't span a whole number of periods or any argument is out of range, including a root frequency
+      outside of that range.
+    */
+    std::optional<MidiTuning> extendTuning(const std::vector<double>& windowTuning, const std::vector<int>& signiature,
+                                           const int& pitchSpaceSize, const double& periodRatio,
+                                           const KeyboardTuningJob& job, const std::string& name);
+
+    /*
+      Returns true if frequency can be given to a key by a MIDI Tuning Standard bulk dump, from MIDI key 0
+      of 12edo with A4 = 440Hz to just short of a semitone above key 127.
+    */
+    bool isFrequencyInMidiRange(const double& frequency);
+
+    /*
+      Writes tuning as a Scala scale and keyboard mapping, an AnaMark tuning, and a MIDI Tuning Standard
+      bulk dump, to basePath with the extensions .scl, .kbm, .tun, and .syx. Returns false if any file
+      couldn't be written.
+    */
+    bool writeFiles(const MidiTuning& tuning, const std::filesystem::path& basePath);
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "Monzo.h"
+
+Monzo::Monzo()
+    : exponents{}
+    , valid{ true }
+{
+}
+
+Monzo::Monzo(const int& n, const int& d)
+    : exponents{}
+{
+    valid = addFactors(n, 1) && addFactors(d, -1);
+}
+
+Monzo::Monzo(const Fraction& fraction)
+    : Monzo(fraction.getNumerator(), fraction.getDenominator())
+{
+}
+
+Monzo Monzo::reciporical() const
+{
+    return power(-1);
+}
+
+long double Monzo::toLongDouble() const
+{
+    if (!valid)
+        return std::numeric_limits<long double>::quiet_NaN();
+
+    long double numerator{ 1 }, denominator{ 1 };
+
+    for (auto primeIndex{ 0 }; primeIndex != primes.size(); ++primeIndex)
+    {
+        auto& product{ exponents[primeIndex] > 0 ? numerator : denominator };
+
+        for (auto factor{ 0 }; factor != std::abs(exponents[primeIndex]); ++factor)
+            product *= primes[primeIndex];
+    }
+
+    return numerator / denominator;
+}
+
+long double Monzo::toCents() const
+{
+    long double logSize{ 0 };
+
+    for (auto primeIndex{ 0 }; primeIndex != primes.size(); ++primeIndex)
+        logSize += exponents[primeIndex] * std::log2((long double)primes[primeIndex]);
+
+    return valid ? 1200 * logSize : std::numeric_limits<long double>::quiet_NaN();
+}
+
+long double Monzo::logTenneyHeight() const
+{
+    long double logHeight{ 0 };
+
+    for (auto primeIndex{ 0 }; primeIndex != primes.size(); ++primeIndex)
+        logHeight += std::abs(exponents[primeIndex]) * std::log2((long double)primes[primeIndex]);
+
+    return logHeight;
+}
+
+bool Monzo::operator<(const Monzo& otherMonzo) const
+{
+    return !(*this == otherMonzo) && toCents() < otherMonzo.toCents();
+}
+
+bool Monzo::operator==(const Monzo& otherMonzo) const
+{
+    return exponents == otherMonzo.exponents && valid == otherMonzo.valid;
+}
+
+Monzo Monzo::operator*(const Monzo& otherMonzo) const
+{
+    auto product{ *this };
+
+    for (auto primeIndex{ 0 }; primeIndex != primes.size(); ++primeIndex)
+        product.exponents[primeIndex] += otherMonzo.exponents[primeIndex];
+
+    product.valid = valid && otherMonzo.valid;
+
+    return product;
+}
+
+Monzo Monzo::power(const int& exponent) const
+{
+    auto result{ *this };
+
+    for (auto& primeExponent : result.exponents)
+        primeExponent *= exponent;
+
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const Monzo& monzo)
+{
+    if (!monzo.valid)
+        return os << "invalid";
+
+    //the ratio can't always be written with int, so it is written as long doubles
+    long double numerator{ 1 }, denominator{ 1 };
+
+    for (auto primeIndex{ 0 }; primeIndex != Monzo::primes.size(); ++primeIndex)
+        (monzo.exponents[primeIndex] > 0 ? numerator : denominator) *= std::pow((long double)Monzo::primes[primeIndex],
+                                                                                 std::abs(monzo.exponents[primeIndex]));
+
+    const auto precision{ os.precision(std::numeric_limits<long double>::digits10) };
+    os << numerator << "/" << denominator;
+    os.precision(precision);
+
+    return os;
+}
+
+bool Monzo::addFactors(int value, const int& sign)
+{
+    if (value <= 0)
+        return false;
+
+    for (auto primeIndex{ 0 }; primeIndex != primes.size(); ++primeIndex)
+        while (value % primes[primeIndex] == 0)
+        {
+            value /= primes[primeIndex];
+            exponents[primeIndex] += sign;
+        }
+
+    return value == 1;
+}
\ No newline at end of file
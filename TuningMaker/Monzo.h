@@ -0,0 +1,118 @@
+#pragma once
+#include "Fraction.h"
+
+/*
+  A ratio stored as the exponents of the primes up to a fixed prime limit (a monzo), so that multiplying
+  ratios adds exponents and raising them to a power scales exponents, neither of which can overflow at any
+  range a Scale can have, as the numerator and denominator of a Fraction can. Ratios with a prime factor
+  above the prime limit can't be represented, and make an invalid monzo.
+*/
+class Monzo
+{
+public:
+    /*
+      The primes whose exponents are stored, which are all primes up to and including the prime limit.
+    */
+    static constexpr std::array<int, 11> primes{ 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31 };
+
+    /*
+      Constructs the monzo of 1/1.
+    */
+    Monzo();
+
+    /*
+      Constructs the monzo of n/d or n/1, which is invalid if either has a prime factor above the prime
+      limit or is not positive.
+    */
+    Monzo(const int& n, const int& d = 1);
+
+    /*
+      Constructs the monzo of fraction.
+    */
+    Monzo(const Fraction& fraction);
+
+    /*
+      Returns false if the monzo doesn't represent a ratio.
+    */
+    inline bool isValid() const
+    {
+        return valid;
+    }
+
+    /*
+      Returns the exponent of primes[primeIndex].
+    */
+    inline int getExponent(const size_t& primeIndex) const
+    {
+        return exponents[primeIndex];
+    }
+
+    /*
+      Returns the reciprocal of the monzo.
+    */
+    Monzo reciporical() const;
+
+    /*
+      Returns the ratio as a long double, exact apart from the final division of its numerator by its
+      denominator while both fit in the mantissa of a long double. NaN if the monzo is invalid.
+    */
+    long double toLongDouble() const;
+
+    /*
+      Returns the size of the ratio in cents.
+    */
+    long double toCents() const;
+
+    /*
+      Returns the base 2 logarithm of the product of the ratio's numerator and denominator, which is the
+      sum of the absolute exponents each weighted by the logarithm of its prime.
+    */
+    long double logTenneyHeight() const;
+
+    /*
+      Less-than comparator operator, comparing the size of the ratios.
+    */
+    bool operator<(const Monzo& otherMonzo) const;
+
+    /*
+      Equal to comparator operator.
+    */
+    bool operator==(const Monzo& otherMonzo) const;
+
+    /*
+      Multiplication operator, which adds the exponents of both monzos.
+    */
+    Monzo operator*(const Monzo& otherMonzo) const;
+
+    /*
+      Returns the monzo raised to the power of exponent, which multiplies every exponent.
+    */
+    Monzo power(const int& exponent) const;
+
+    /*
+      Ostream input, as the ratio n/d.
+    */
+    friend std::ostream& operator<<(std::ostream& os, const Monzo& monzo);
+
+private:
+    std::array<int, primes.size()> exponents;
+    bool valid;
+
+    /*
+      Adds the exponents of the prime factors of value multiplied by sign to exponents. Returns false if
+      value has a prime factor above the prime limit or isn't positive.
+    */
+    bool addFactors(int value, const int& sign);
+};
+
+/*
+  Returns the Tenney height of monzo, one over the product of its numerator and denominator, raised to the
+  power of entropyCurve, as tenneyHeightOfFraction() does for a Fraction. 0 if the monzo is invalid.
+*/
+static long double tenneyHeightOfMonzo(const Monzo& monzo, const long double& entropyCurve = 1)
+{
+    if (!monzo.isValid())
+        return 0;
+
+    return std::exp2(-monzo.logTenneyHeight() * entropyCurve);
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include "Utilities.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+/*
+  A set of note indecies in [0, maxMidiNotes) stored as one bit per note. A NoteSet never allocates, so
+  it can be copied, modified and restored freely while traversing a scale. Notes are visited in ascending
+  order by popFirst().
+*/
+class NoteSet
+{
+public:
+    /*
+      The number of notes a NoteSet can hold.
+    */
+    static constexpr size_t capacity{ maxMidiNotes };
+
+    /*
+      Constructs an empty set.
+    */
+    constexpr NoteSet()
+        : words{}
+    {
+    }
+
+    /*
+      Returns a set of the notes [0, noteCount).
+    */
+    static NoteSet firstNotes(const size_t& noteCount)
+    {
+        NoteSet notes;
+
+        for (auto word{ 0 }; word != wordCount; ++word)
+        {
+            const auto notesInWord{ std::min<size_t>(noteCount - std::min<size_t>(noteCount, word * bitsPerWord), bitsPerWord) };
+
+            notes.words[word] = notesInWord == bitsPerWord ? ~uint64_t(0) : (uint64_t(1) << notesInWord) - 1;
+        }
+
+        return notes;
+    }
+
+    /*
+      Adds note to the set.
+    */
+    inline void insert(const int& note)
+    {
+        words[note / bitsPerWord] |= uint64_t(1) << (note % bitsPerWord);
+    }
+
+    /*
+      Removes note from the set.
+    */
+    inline void erase(const int& note)
+    {
+        words[note / bitsPerWord] &= ~(uint64_t(1) << (note % bitsPerWord));
+    }
+
+    /*
+      Returns true if note is in the set.
+    */
+    inline bool contains(const int& note) const
+    {
+        return (words[note / bitsPerWord] >> (note % bitsPerWord)) & 1;
+    }
+
+    /*
+      Returns true if the set contains no notes.
+    */
+    inline bool empty() const
+    {
+        for (const auto& word : words)
+            if (word != 0)
+                return false;
+
+        return true;
+    }
+
+    /*
+      Returns the number of notes in the set.
+    */
+    inline int size() const
+    {
+        auto noteCount{ 0 };
+
+        for (const auto& word : words)
+            noteCount += std::popcount(word);
+
+        return noteCount;
+    }
+
+    /*
+      Removes the lowest note from a set which is not empty and returns it.
+    */
+    inline int popFirst()
+    {
+        for (auto word{ 0 }; word != wordCount; ++word)
+            if (words[word] != 0)
+            {
+                const auto bit{ std::countr_zero(words[word]) };
+                words[word] &= words[word] - 1;
+
+                return word * bitsPerWord + bit;
+            }
+
+        return -1;
+    }
+
+    /*
+      Equal to comparator operator.
+    */
+    bool operator==(const NoteSet& otherNoteSet) const = default;
+
+    /*
+      The number of notes stored in each word of the set, and the number of words.
+    */
+    static constexpr int bitsPerWord{ 64 };
+    static constexpr int wordCount{ (capacity + bitsPerWord - 1) / bitsPerWord };
+
+    /*
+      Returns the word holding notes [word * bitsPerWord, (word + 1) * bitsPerWord), with the lowest note in
+      the least significant bit.
+    */
+    inline uint64_t getWord(const int& word) const
+    {
+        return words[word];
+    }
+
+    /*
+      Replaces the word holding notes [word * bitsPerWord, (word + 1) * bitsPerWord).
+    */
+    inline void setWord(const int& word, const uint64_t& newWord)
+    {
+        words[word] = newWord;
+    }
+
+private:
+    uint64_t words[wordCount];
+};
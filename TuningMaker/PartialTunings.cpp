@@ -0,0 +1,136 @@
+#include "PartialTunings.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+static constexpr char fileMagic[8]{ 'T', 'M', 'P', 'A', 'R', 'T', 'S', '1' };
+
+/*
+  The most notes partial tunings read from a file may have, so that a corrupt note count can't exhaust
+  memory.
+*/
+static constexpr uint64_t maxFileNoteCount{ 1024 };
+
+PartialTunings::PartialTunings(const std::string& k, const size_t& n)
+    : key(k)
+    , noteCount(n)
+    , tunings(n * n, 0)
+    , isTuned(n * n, 0)
+{
+}
+
+size_t PartialTunings::getTunedCount() const
+{
+    return (size_t)std::count(isTuned.begin(), isTuned.end(), 1);
+}
+
+bool PartialTunings::isComplete() const
+{
+    return getTunedCount() == isTuned.size();
+}
+
+bool PartialTunings::add(const PartialTunings& otherTunings)
+{
+    if (otherTunings.key != key || otherTunings.noteCount != noteCount)
+        return false;
+
+    for (size_t pair{ 0 }; pair != isTuned.size(); ++pair)
+        if (otherTunings.isTuned[pair])
+        {
+            tunings[pair] = otherTunings.tunings[pair];
+            isTuned[pair] = 1;
+        }
+
+    return true;
+}
+
+bool PartialTunings::writeFile(const std::filesystem::path& path) const
+{
+    //written under a name no other writer can be using, then renamed into place
+    auto temporaryPath{ path };
+    temporaryPath += "." + std::to_string(std::random_device()()) + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        const uint64_t longDoubleSize{ sizeof(long double) };
+        const uint64_t keyLength{ key.size() };
+        const uint64_t fileNoteCount{ noteCount };
+
+        file.write(fileMagic, sizeof(fileMagic));
+        file.write(reinterpret_cast<const char*>(&longDoubleSize), sizeof(longDoubleSize));
+        file.write(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+        file.write(key.data(), keyLength);
+        file.write(reinterpret_cast<const char*>(&fileNoteCount), sizeof(fileNoteCount));
+        file.write(reinterpret_cast<const char*>(isTuned.data()), isTuned.size());
+        file.write(reinterpret_cast<const char*>(tunings.data()), tunings.size() * sizeof(long double));
+
+        if (!file.flush())
+        {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<PartialTunings> PartialTunings::readFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    char magic[sizeof(fileMagic)]{};
+    uint64_t longDoubleSize{ 0 }, keyLength{ 0 };
+
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&longDoubleSize), sizeof(longDoubleSize));
+    file.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+
+    if (!file || !std::equal(magic, magic + sizeof(magic), fileMagic) || longDoubleSize != sizeof(long double))
+        return std::nullopt;
+
+    //a key longer than the file can hold is corrupt
+    std::error_code error;
+    const auto fileSize{ std::filesystem::file_size(path, error) };
+
+    if (error || keyLength > fileSize)
+        return std::nullopt;
+
+    std::string key(keyLength, '\0');
+    uint64_t noteCount{ 0 };
+
+    file.read(key.data(), keyLength);
+    file.read(reinterpret_cast<char*>(&noteCount), sizeof(noteCount));
+
+    if (!file || noteCount > maxFileNoteCount)
+        return std::nullopt;
+
+    PartialTunings partialTunings(key, noteCount);
+
+    file.read(reinterpret_cast<char*>(partialTunings.isTuned.data()), partialTunings.isTuned.size());
+    file.read(reinterpret_cast<char*>(partialTunings.tunings.data()),
+              partialTunings.tunings.size() * sizeof(long double));
+
+    if (!file)
+        return std::nullopt;
+
+    //getTunedCount() counts flags of exactly 1
+    for (auto& pairIsTuned : partialTunings.isTuned)
+        pairIsTuned = pairIsTuned == 1;
+
+    return partialTunings;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+  Some of the populated tunings of a scale, those of the (rootNote, note) pairs which have been tuned, so
+  that the tuning of a scale can be shared between processes or picked up after it was interrupted. Made
+  by Scale::tuneShard() and combined by Scale::mergeShards().
+*/
+struct PartialTunings
+{
+    /*
+      Describes everything the tunings depend on, the scale and the settings it was tuned with, as the key of
+      a TuningCache entry does. Partial tunings are only combined with others which have the same key.
+    */
+    std::string key;
+    size_t noteCount{ 0 };
+    /*
+      At rootNote * noteCount + note, the tuning of note for rootNote, and whether it has been tuned. A
+      tuning which has not been tuned is 0.
+    */
+    std::vector<long double> tunings;
+    std::vector<uint8_t> isTuned;
+
+    /*
+      Constructs partial tunings of noteCount notes with nothing tuned.
+    */
+    PartialTunings(const std::string& key = std::string(), const size_t& noteCount = 0);
+
+    /*
+      Returns the number of pairs tuned.
+    */
+    size_t getTunedCount() const;
+
+    /*
+      Returns true if every pair has been tuned.
+    */
+    bool isComplete() const;
+
+    /*
+      Adds every pair tuned in otherTunings to these. Returns false, adding nothing, if otherTunings has a
+      different key or number of notes.
+    */
+    bool add(const PartialTunings& otherTunings);
+
+    /*
+      Writes the tunings to path, first to a temporary file beside it which is then renamed over path, so
+      that path always holds either the tunings written before or all of these. Returns false if they can't
+      be written, in which case path is unchanged. Long doubles are written as they are in memory, so the
+      file can only be read by a process in which they have the same size.
+    */
+    bool writeFile(const std::filesystem::path& path) const;
+
+    /*
+      Returns the tunings written to path by writeFile(), or std::nullopt if there are none or they can't
+      be read.
+    */
+    static std::optional<PartialTunings> readFile(const std::filesystem::path& path);
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "PathSampler.h"
+
+/*
+  The SplitMix64 finaliser, which maps consecutive integers to well mixed 64 bit values.
+*/
+static uint64_t mixBits(uint64_t bits)
+{
+    bits += 0x9E3779B97F4A7C15;
+    bits = (bits ^ (bits >> 30)) * 0xBF58476D1CE4E5B9;
+    bits = (bits ^ (bits >> 27)) * 0x94D049BB133111EB;
+
+    return bits ^ (bits >> 31);
+}
+
+template<typename Real>
+PathSampler<Real>::PathSampler(const IntervalMatrix<Real>& matrix, const int& root, const int& n, const Real& cutoff,
+                               const uint64_t& seed)
+    : intervalMatrix(matrix)
+    , rootNote(root)
+    , note(n)
+    , weightCutoff(cutoff)
+    , generator(seed)
+{
+}
+
+template<typename Real>
+void PathSampler<Real>::sample(const size_t& newSampleCount)
+{
+    for (size_t path{ 0 }; path != newSampleCount; ++path)
+    {
+        const auto logTuning{ samplePath() };
+
+        ++sampleCount;
+
+        const auto difference{ logTuning - meanLogTuning };
+        meanLogTuning += difference / (Real)sampleCount;
+        squaredDifferencesSum += difference * (logTuning - meanLogTuning);
+    }
+}
+
+template<typename Real>
+Real PathSampler<Real>::getMeanLogTuningVariance() const
+{
+    if (sampleCount < 2)
+        return 0;
+
+    return squaredDifferencesSum / (Real)(sampleCount - 1) / (Real)sampleCount;
+}
+
+template<typename Real>
+uint64_t PathSampler<Real>::pairSeed(const uint64_t& seed, const int& rootNote, const int& note)
+{
+    return mixBits(mixBits(seed) ^ ((uint64_t)rootNote << 32 | (uint32_t)note));
+}
+
+template<typename Real>
+Real PathSampler<Real>::samplePath()
+{
+    const auto& noteCount{ intervalMatrix.noteCount };
+
+    auto possibleNextNotes{ NoteSet::firstNotes(noteCount) };
+    possibleNextNotes.erase(note);
+
+    Real logTuning{ 0 };
+    Real rollingWeight{ 1 };
+    auto lastNote{ note };
+
+    while (true)
+    {
+        const auto* weightsToLastNote{ &intervalMatrix.weights[lastNote * noteCount] };
+
+        Real weightSum{ 0 };
+        for (auto remainingNotes{ possibleNextNotes }; !remainingNotes.empty();)
+            weightSum += weightsToLastNote[remainingNotes.popFirst()];
+
+        //the same rolling weight ScaleTraversal gives the node at lastNote
+        rollingWeight = clampToLimits<Real>(rollingWeight / weightSum);
+
+        //53 random bits make a uniform double in [0, 1) on every platform
+        const auto threshold{ (Real)((double)(generator() >> 11) * 0x1p-53) * weightSum };
+
+        auto nextNote{ -1 };
+        Real cumulativeWeight{ 0 };
+
+        for (auto remainingNotes{ possibleNextNotes }; !remainingNotes.empty();)
+        {
+            nextNote = remainingNotes.popFirst();
+            cumulativeWeight += weightsToLastNote[nextNote];
+
+            if (cumulativeWeight > threshold)
+                break;
+        }
+
+        const auto nextWeight{ weightsToLastNote[nextNote] };
+
+        const auto endsPath{ nextNote == rootNote || nextWeight * rollingWeight <= weightCutoff };
+
+        if constexpr (tuningStatisticsEnabled)
+            TuningCounters::countNode(noteCount - 1 - possibleNextNotes.size(), endsPath, nextNote == rootNote);
+
+        if (endsPath)
+            return logTuning + intervalMatrix.logSizes[lastNote * noteCount + rootNote];
+
+        logTuning += intervalMatrix.logSizes[lastNote * noteCount + nextNote];
+        rollingWeight *= nextWeight;
+        possibleNextNotes.erase(nextNote);
+        lastNote = nextNote;
+    }
+}
+
+template class PathSampler<float>;
+template class PathSampler<double>;
+template class PathSampler<long double>;
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include "ScaleTraversal.h"
+#include <cstdint>
+#include <random>
+
+/*
+  Estimates the log tuning a ScaleTraversal calculates by following random paths through the scale instead
+  of every path. From each note a path moves to one of the notes not yet in it with probability
+  proportional to the weight of the interval between them, which are the factors ScaleTraversal weights
+  each branch by, and it ends where ScaleTraversal would treat it as reaching the root note. The mean of
+  the summed log sizes along the paths is an unbiased estimate of the log tuning, and takes time linear in
+  the number of paths however large the scale or small the weight cutoff. A sampler reads the
+  IntervalMatrix it was constructed with, which must outlive it.
+*/
+template<typename Real>
+class PathSampler
+{
+public:
+    /*
+      Constructs a sampler of paths from note to rootNote of the scale whose intervals are in matrix. The
+      paths it follows depend only on seed, so equal seeds give equal estimates.
+    */
+    PathSampler(const IntervalMatrix<Real>& matrix, const int& rootNote, const int& note, const Real& weightCutoff,
+                const uint64_t& seed);
+
+    /*
+      Follows sampleCount more paths.
+    */
+    void sample(const size_t& sampleCount);
+
+    /*
+      Returns the number of paths followed so far.
+    */
+    inline size_t getSampleCount() const
+    {
+        return sampleCount;
+    }
+
+    /*
+      Returns the mean base 2 logarithm of the paths followed so far.
+    */
+    inline Real getMeanLogTuning() const
+    {
+        return meanLogTuning;
+    }
+
+    /*
+      Returns the variance of getMeanLogTuning() as an estimate of the true log tuning, or 0 if fewer than
+      two paths have been followed.
+    */
+    Real getMeanLogTuningVariance() const;
+
+    /*
+      Returns a seed for the pair (rootNote, note) derived from seed, such that the seeds of different
+      pairs give unrelated paths.
+    */
+    static uint64_t pairSeed(const uint64_t& seed, const int& rootNote, const int& note);
+
+private:
+    const IntervalMatrix<Real>& intervalMatrix;
+    int rootNote;
+    int note;
+    Real weightCutoff;
+
+    std::mt19937_64 generator;
+
+    /*
+      The running mean and sum of squared differences from the mean of the sampled log tunings, updated
+      with Welford's method.
+    */
+    size_t sampleCount{ 0 };
+    Real meanLogTuning{ 0 };
+    Real squaredDifferencesSum{ 0 };
+
+    /*
+      Follows one random path and returns the sum of the base 2 logarithms of the intervals along it.
+    */
+    Real samplePath();
+};
\ No newline at end of file
@@ -1,13 +1,41 @@
 #pragma once
 #include "Fraction.h"
 #include "Scale.h"
+#include "MidiTuning.h"
+#include "BuiltInPitchSpaces.h"
 #include <string>
 #include <map>
+#include <memory>
 #include <optional>
 #include <algorithm>
 
 using ScaleSigniature = std::vector<int>;
 
+/*
+  One tuning of a scale in a pitch space, to be calculated by PitchSpace::tuneBatch().
+*/
+struct BatchTuningJob
+{
+    std::string signiatureName;
+    int range;
+    /*
+      The exponent of the Tenney height used to weight each interval in fractional and monzo pitch spaces.
+      Decimal pitch spaces weight every interval equally and ignore it.
+    */
+    long double entropyCurve{ 1 };
+    long double weightCutoff{ 0 };
+    int trueRootNote{ 0 };
+    /*
+      Whether the tuning includes NaN dummy notes for the notes of the pitch space not in the scale.
+    */
+    bool withDummyNotes{ false };
+    /*
+      If not empty, the job is checkpointed to this file, and resumed from it if it already holds a
+      checkpoint of the job, as Scale::resumeTuneScale() does.
+    */
+    std::filesystem::path checkpointPath;
+};
+
 /*
   A PitchSpace represents the total pitch materials which a scale could be constructed from (think of all
   the different scales which "belong" in the chromatic 12edo pitch space). Pitch space stores this information
@@ -26,7 +54,9 @@ public:
     PitchSpace(const std::vector<Relation>& t)
         : table(t)
     {
-        std::sort(table.begin(), table.end());
+        //the built-in tables are sorted at compile time
+        if (!std::is_sorted(table.begin(), table.end()))
+            std::sort(table.begin(), table.end());
 
         if (table[0] == Relation(1))
             table.erase(table.begin());
@@ -72,7 +102,7 @@ public:
 
         const auto intervalSizeGreaterThanZero{ intervalSize > 0 };
 
-        if constexpr (std::is_same_v<Relation, Fraction>)
+        if constexpr (!std::is_floating_point_v<Relation>)
         {
             const auto returnRelation{ relationPart * relationOfRepetition().power(exponent) };
 
@@ -124,6 +154,134 @@ public:
         return extendedScaleFractions;
     }
 
+    /*
+      Tunes the scale of every job, returning the tunings in the same order as jobs. A tuning is
+      std::nullopt if its job names a signiature which does not exist, has a range <= 1, has a
+      trueRootNote outside of [0, range), or if the batch is cancelled. Every job is tuned according to
+      settings apart from its weightCutoff and checkpointPath, on settings.threadPool or, if that is nullptr, on a pool made
+      for the batch. Jobs which share a signiature and range share the relations made for them. Progress
+      is only reported through settings.progressCallback, separately for each job. If set, jobFinished is
+      called with the index and tuning of each job as soon as it finishes, from the thread which tuned it.
+    */
+    std::vector<std::optional<std::vector<double>>> tuneBatch(const std::vector<BatchTuningJob>& jobs,
+                                                              const TuningSettings& settings,
+                                                              const std::function<void(const size_t&,
+                                                                  const std::optional<std::vector<double>>&)>& jobFinished = {}) const
+    {
+        std::unique_ptr<ThreadPool> batchThreadPool;
+        auto* threadPool{ settings.threadPool };
+
+        if (threadPool == nullptr)
+        {
+            batchThreadPool = std::make_unique<ThreadPool>();
+            threadPool = batchThreadPool.get();
+        }
+
+        std::map<std::pair<std::string, int>, std::optional<std::vector<std::vector<Relation>>>> rangedScaleRelations;
+
+        for (const auto& job : jobs)
+        {
+            const auto key{ std::make_pair(job.signiatureName, job.range) };
+
+            if (rangedScaleRelations.find(key) == rangedScaleRelations.end())
+                rangedScaleRelations.insert({ key, makeRangedScaleRelations(job.signiatureName, job.range) });
+        }
+
+        std::vector<std::optional<std::vector<double>>> tunings(jobs.size());
+
+        TaskGroup tasks(*threadPool);
+
+        for (auto jobIndex{ 0 }; jobIndex != jobs.size(); ++jobIndex)
+        {
+            const auto& job{ jobs[jobIndex] };
+            const auto& relations{ rangedScaleRelations.at(std::make_pair(job.signiatureName, job.range)) };
+
+            if (!relations.has_value() || job.trueRootNote < 0 || job.trueRootNote >= job.range)
+            {
+                if (jobFinished)
+                    jobFinished(jobIndex, tunings[jobIndex]);
+
+                continue;
+            }
+
+            tasks.run([&, jobIndex]()
+                {
+                    const auto& job{ jobs[jobIndex] };
+                    const auto scale{ makeScale(job, relations.value()) };
+
+                    auto jobSettings{ settings };
+                    jobSettings.weightCutoff = job.weightCutoff;
+                    jobSettings.checkpointPath = job.checkpointPath;
+                    jobSettings.threadPool = threadPool;
+                    jobSettings.silent = true;
+
+                    auto tuning{ job.checkpointPath.empty() ? scale.tuneScale(job.trueRootNote, jobSettings)
+                                                            : scale.resumeTuneScale(job.trueRootNote, jobSettings) };
+
+                    if (!tuning.empty())
+                        tunings[jobIndex] = std::move(tuning);
+
+                    if (jobFinished)
+                        jobFinished(jobIndex, tunings[jobIndex]);
+                });
+        }
+
+        tasks.wait();
+
+        return tunings;
+    }
+
+    /*
+      Returns the scale job tunes, with its dummy notes if it has them, or std::nullopt if job names a
+      signiature which does not exist or has a range <= 1. job.weightCutoff and job.trueRootNote are not
+      part of the scale, so are ignored.
+    */
+    std::optional<Scale> makeScale(const BatchTuningJob& job) const
+    {
+        const auto relations{ makeRangedScaleRelations(job.signiatureName, job.range) };
+
+        if (!relations.has_value())
+            return std::nullopt;
+
+        return makeScale(job, relations.value());
+    }
+
+    /*
+      Tunes job.periods periods of the named signiature, and extends the tuning across every MIDI key
+      with KeyboardTuning::extendTuning(), repeating it every relationOfRepetition(). Tuned according to
+      settings apart from its weightCutoff, as tuneBatch() tunes. Returns std::nullopt if the signiature
+      doesn't exist, job is invalid, or the tuning is cancelled.
+    */
+    std::optional<MidiTuning> tuneKeyboard(const KeyboardTuningJob& job, const TuningSettings& settings) const
+    {
+        const auto signiature{ getSigniature(job.signiatureName) };
+
+        if (!signiature.has_value() || job.periods < 1
+            || job.periods * signiature->size() + 1 > maxMidiNotes)
+            return std::nullopt;
+
+        BatchTuningJob windowJob;
+        windowJob.signiatureName = job.signiatureName;
+        windowJob.range = job.periods * signiature->size() + 1;
+        windowJob.entropyCurve = job.entropyCurve;
+        windowJob.weightCutoff = job.weightCutoff;
+
+        const auto windowTuning{ tuneBatch({ windowJob }, settings)[0] };
+
+        if (!windowTuning.has_value())
+            return std::nullopt;
+
+        double periodRatio;
+
+        if constexpr (!std::is_floating_point_v<Relation>)
+            periodRatio = relationOfRepetition().toLongDouble();
+        else
+            periodRatio = relationOfRepetition();
+
+        return KeyboardTuning::extendTuning(windowTuning.value(), signiature.value(), size(), periodRatio, job,
+                                            job.signiatureName);
+    }
+
     /*
       Returns a vector of indecies NOT in the named signiature extended to range if that scale exists.
     */
@@ -241,6 +399,30 @@ private:
     */
     std::map<std::string, ScaleSigniature> scaleSigniatures;
 
+    /*
+      Returns the scale of relations, the ranged scale relations of job, weighted as this kind of pitch space
+      weights its relations, with job's dummy notes if it has them.
+    */
+    Scale makeScale(const BatchTuningJob& job, const std::vector<std::vector<Relation>>& relations) const
+    {
+        Scale scale;
+
+        if constexpr (std::is_same_v<Relation, Fraction>)
+            scale = Scale(IntervalPatternMakers::rangedScaleFractionsToIntervalsWithTenneyWeight(relations, job.entropyCurve),
+                          job.signiatureName);
+        else if constexpr (std::is_same_v<Relation, Monzo>)
+            scale = Scale(IntervalPatternMakers::rangedScaleMonzosToIntervalsWithTenneyWeight(relations, job.entropyCurve),
+                          job.signiatureName);
+        else
+            scale = Scale(IntervalPatternMakers::rangedScaleLongDoubleToIntervalsWithUniformWeight(relations),
+                          job.signiatureName);
+
+        if (job.withDummyNotes)
+            scale.setDummyIndecies(getDummyIndecies(job.signiatureName, job.range));
+
+        return scale;
+    }
+
     /*
       Returns the index of note in the scale signiature even if that note exceeds the index of the
       signiature by imagining where it would be if the pattern of the signiature extended to include
@@ -289,100 +471,73 @@ private:
 namespace PitchSpaces
 {
     /*
-      Standard pitch spaces with ideal fractional relations.
+      Every pitch space which can be used by name, fractional ones having ideal fractional relations and
+      decimal ones ideal decimal (long double) relations.
     */
-    static std::map<std::string, PitchSpace<Fraction>> fractional
+    struct Registry
     {
-        {"7edo",
-        { { { 10, 9 },
-            { 11, 9 },
-            { 4, 3 },
-            { 3, 2 },
-            { 13, 8 },
-            { 9, 5 },
-            { 2 }
-        } } },
-        {"12edo",
-        { { { 17, 16 },
-            { 9, 8 },
-            { 6, 5 },
-            { 5, 4 },
-            { 4, 3 },
-            { 7, 5 },
-            { 3, 2 },
-            { 8, 5 },
-            { 5, 3 },
-            { 9, 5 },
-            { 15, 8 },
-            { 2 }
-        } } },
-        {"17edo",
-        { { { 24, 23 },
-            { 12, 11 },
-            { 8, 7 },
-            { 7, 6 },
-            { 11, 9 },
-            { 9, 7 },
-            { 4, 3 },
-            { 11, 8 },
-            { 13, 9 },
-            { 3, 2 },
-            { 11, 7 },
-            { 13, 8 },
-            { 12, 7 },
-            { 7, 4 },
-            { 11, 6 },
-            { 23, 12 },
-            { 2 }
-        } } },
-        {"22edo",
-        { { { 32, 31 },
-            { 16, 15 },
-            { 8, 7 },
-            { 11, 10 },
-            { 9, 8 },
-            { 7, 6 },
-            { 6, 5 },
-            { 5, 4 },
-            { 9, 7 },
-            { 4, 3 },
-            { 11, 8 },
-            { 7, 5 },
-            { 16, 11 },
-            { 3, 2 },
-            { 11, 7 },
-            { 8, 5 },
-            { 5, 3 },
-            { 12, 7 },
-            { 7, 4 },
-            { 9, 5 },
-            { 15, 8 },
-            { 31, 16 },
-            { 2 }
-        } } },
-        {"15edo",
-        { { { 21, 20 },
-            { 11, 10 },
-            { 8, 7 },
-            { 6, 5 },
-            { 5, 4 },
-            { 4, 3 },
-            { 11, 8 },
-            { 16, 11 },
-            { 3, 2 },
-            { 8, 5 },
-            { 5, 3 },
-            { 7, 4 },
-            { 11, 6 },
-            { 21, 11 },
-            { 2 }
-        } } },
+        std::map<std::string, PitchSpace<Fraction>> fractional;
+        std::map<std::string, PitchSpace<long double>> decimal;
     };
 
     /*
-      Standard pitch spaces with ideal decimal (long double) relations.
+      Adds the built-in pitch space table and its scales to pitchSpaces.
+    */
+    template<size_t RelationCount, size_t SigniatureCount>
+    void addBuiltInPitchSpace(std::map<std::string, PitchSpace<Fraction>>& pitchSpaces,
+                              const BuiltInPitchSpaces::Table<RelationCount, SigniatureCount>& builtInTable)
+    {
+        std::vector<Fraction> relations;
+        relations.reserve(RelationCount);
+
+        for (const auto& relation : builtInTable.relations)
+            relations.push_back({ relation.numerator, relation.denominator });
+
+        auto& pitchSpace{ pitchSpaces.emplace(builtInTable.name, relations).first->second };
+
+        for (const auto& signiature : builtInTable.signiatures)
+            pitchSpace.addSigniature(std::string(signiature.name),
+                                     { signiature.notes.begin(), signiature.notes.begin() + signiature.noteCount });
+    }
+
+    /*
+      Returns the registry of pitch spaces, which is created with the built-in pitch spaces the first time
+      it is used, and is shared by every translation unit.
+    */
+    inline Registry& registry()
+    {
+        static Registry pitchSpaces{ []
+            {
+                Registry builtInPitchSpaces;
+
+                addBuiltInPitchSpace(builtInPitchSpaces.fractional, BuiltInPitchSpaces::sevenEDO);
+                addBuiltInPitchSpace(builtInPitchSpaces.fractional, BuiltInPitchSpaces::twelveEDO);
+                addBuiltInPitchSpace(builtInPitchSpaces.fractional, BuiltInPitchSpaces::seventeenEDO);
+                addBuiltInPitchSpace(builtInPitchSpaces.fractional, BuiltInPitchSpaces::twentytwoEDO);
+                addBuiltInPitchSpace(builtInPitchSpaces.fractional, BuiltInPitchSpaces::fifteenEDO);
+
+                return builtInPitchSpaces;
+            }()
+        };
+
+        return pitchSpaces;
+    }
+
+    /*
+      Pitch spaces with ideal fractional relations.
     */
-    static std::map<std::string, PitchSpace<long double>> decimal;
+    inline std::map<std::string, PitchSpace<Fraction>>& fractional()
+    {
+        return registry().fractional;
+    }
+
+    /*
+      Pitch spaces with ideal decimal (long double) relations.
+    */
+    inline std::map<std::string, PitchSpace<long double>>& decimal()
+    {
+        return registry().decimal;
+    }
 
     /*
       Prints all pitch spaces in the form:
@@ -401,31 +556,4 @@ namespace PitchSpaces
 			std::cout << std::endl << std::endl;
         }
     }
-    
-    /*
-      Adds some scales to pitch spaces.
-    */
-    static void initialisePitchSpaceScales()
-    {
-        auto& sevenEDO{ PitchSpaces::fractional.at("7edo") };
-
-        sevenEDO.addSigniature("neutral_pentatonic_A", { 0, 1, 3, 4, 6 });
-        sevenEDO.addSigniature("neutral_pentatonic_B", { 0, 2, 3, 5, 6 });
-
-        auto& twelveEDO{ PitchSpaces::fractional.at("12edo") };
-
-        twelveEDO.addSigniature("major_pentatonic", { 0, 2, 4, 7, 9 });
-        twelveEDO.addSigniature("minor_pentatonic", { 0, 3, 4, 7, 10 });
-        twelveEDO.addSigniature("ionian", { 0, 2, 4, 5, 7, 9, 11 });
-        twelveEDO.addSigniature("dorian", { 0, 2, 3, 5, 7, 9, 10 });
-        twelveEDO.addSigniature("phrygian", { 0, 1, 3, 5, 7, 8, 10 });
-        twelveEDO.addSigniature("lydian", { 0, 2, 4, 6, 7, 9, 11 });
-        twelveEDO.addSigniature("myxolydian", { 0, 2, 4, 5, 7, 9, 10 });
-        twelveEDO.addSigniature("aolian", { 0, 2, 3, 5, 7, 8, 10 });
-        twelveEDO.addSigniature("locrian", { 0, 1, 3, 5, 6, 8, 10 });
-
-        auto& twentytwoEDO{ PitchSpaces::fractional.at("22edo") };
-
-        twentytwoEDO.addSigniature("orwell9", { 0, 3, 5, 8, 10, 13, 15, 18, 20 });
-    }
 }
\ No newline at end of file
@@ -1,91 +1,273 @@
 #include "Scale.h"
 #include <algorithm>
+#include <bit>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+/*
+  Working memory reused by every tuning job run on a thread, so that jobs do not allocate once the
+  buffers have grown to the size of the largest scale tuned on that thread.
+*/
+template<typename Real>
+struct TraversalScratch
+{
+    std::vector<Real> weights;
+    std::vector<Real> logSizes;
+    std::vector<Real> weightsToRootNote;
+    std::vector<Real> logSizesToRootNote;
+    std::vector<Real> remainingWeightSums;
+    /*
+      The weights and sizes of the siblings traversed below a node, at depth * noteCount.
+    */
+    std::vector<Real> siblingWeights;
+    std::vector<Real> siblingSizes;
+};
+
+/*
+  Returns the TraversalScratch of the calling thread.
+*/
+template<typename Real>
+static TraversalScratch<Real>& traversalScratch()
+{
+    static thread_local TraversalScratch<Real> scratch;
 
-Interval::Interval()
-    : size{ 1 }
-    , weight{ 1 }
+    return scratch;
+}
+
+/*
+  The bytes of exactSubsetsMemoryBudget held by memo tables, over every scale in the process, so that
+  concurrent tunings, such as those of a batch, share the budget too.
+*/
+static std::mutex exactSubsetsMemoryMutex;
+static std::condition_variable exactSubsetsMemoryFreed;
+static size_t exactSubsetsBytesReserved{ 0 };
+
+/*
+  Holds bytes of exactSubsetsMemoryBudget for as long as it exists, first waiting until they are free.
+*/
+class ExactSubsetsMemoryReservation
+{
+public:
+    ExactSubsetsMemoryReservation(const size_t& b)
+        : bytes(b)
+    {
+        std::unique_lock<std::mutex> lock(exactSubsetsMemoryMutex);
+
+        exactSubsetsMemoryFreed.wait(lock, [this]()
+            {
+                return exactSubsetsBytesReserved == 0 || exactSubsetsBytesReserved + bytes <= exactSubsetsMemoryBudget;
+            });
+
+        exactSubsetsBytesReserved += bytes;
+    }
+
+    ~ExactSubsetsMemoryReservation()
+    {
+        {
+            std::lock_guard<std::mutex> lock(exactSubsetsMemoryMutex);
+            exactSubsetsBytesReserved -= bytes;
+        }
+
+        exactSubsetsMemoryFreed.notify_all();
+    }
+
+    ExactSubsetsMemoryReservation(const ExactSubsetsMemoryReservation&) = delete;
+    ExactSubsetsMemoryReservation& operator=(const ExactSubsetsMemoryReservation&) = delete;
+
+private:
+    size_t bytes;
+};
+
+/*
+  The number of steps a traversal takes between checks of its cancellation token.
+*/
+static constexpr size_t cancellationCheckSteps{ 4096 };
+
+/*
+  The number of nodes, or for TuningEngine::monteCarlo the number of paths, a Scale times to measure how long
+  each takes, which is enough to take a few milliseconds.
+*/
+static constexpr double calibrationNodeCount{ 50000 };
+
+/*
+  The number of steps Scale::tuneScaleUntil() takes of a traversal between checks of its deadline.
+*/
+static constexpr size_t anytimeDeadlineCheckSteps{ 1024 };
+
+/*
+  The weight cutoff of the first pass of Scale::tuneScaleUntil().
+*/
+static constexpr long double anytimeFirstWeightCutoff{ 0.1L };
+
+/*
+  Scale::tuneScaleUntil() plans each pass to take this many times as long as the pass before it, until
+  that would be more than anytimeCalibrationShare of the time left, so that the passes before the last
+  take little of the time but measure how long it will take.
+*/
+static constexpr double anytimePassGrowth{ 8 };
+
+/*
+  The share of the time left before its deadline which a pass of Scale::tuneScaleUntil() before the last
+  may take. Once a pass has taken at least half this share, the next is planned to be the last.
+*/
+static constexpr double anytimeCalibrationShare{ 1.0 / 16 };
+
+/*
+  The share of the time left before its deadline Scale::tuneScaleUntil() plans its last pass to take,
+  leaving the rest for the error of the plan.
+*/
+static constexpr double anytimeLastPassTimeShare{ 0.85 };
+
+/*
+  The most the weight cutoff of a pass of Scale::tuneScaleUntil() may be of that of the pass before it,
+  so that each pass traverses enough more than the last to be worth running.
+*/
+static constexpr long double anytimeMaxCutoffRatio{ 0.5L };
+
+/*
+  The power of the reciprocal of the weight cutoff which Scale::tuneScaleUntil() takes the number of
+  steps of a pass to grow as until two passes have measured it, and the least and most it takes it to be
+  after.
+*/
+static constexpr double anytimeDefaultGrowthExponent{ 0.75 };
+static constexpr double anytimeMinGrowthExponent{ 0.25 };
+static constexpr double anytimeMaxGrowthExponent{ 2 };
+
+/*
+  Returns true if the tuning calculated with settings has been cancelled.
+*/
+static bool isCancelled(const TuningSettings& settings)
 {
+    return settings.cancellationToken != nullptr && settings.cancellationToken->isCancelled();
 }
 
-Interval::Interval(const long double& s, const long double& w)
-    : size{ clampLongDoubleToLimits(s) }
-    , weight{ clampLongDoubleToLimits(w) }
+/*
+  Appends the bytes of value to key, least significant first.
+*/
+static void appendToCacheKey(std::string& key, const uint64_t& value)
 {
-    manageZeroWeight();
+    for (auto byte{ 0 }; byte != 8; ++byte)
+        key += (char)(value >> byte * 8);
+}
+
+/*
+  Appends value to key as its sign, exponent, and mantissa, which are the same however value is laid out in
+  memory.
+*/
+static void appendToCacheKey(std::string& key, const long double& value)
+{
+    if (std::isnan(value))
+    {
+        key += 'n';
+
+        return;
+    }
+
+    key += std::signbit(value) ? '-' : '+';
+
+    if (std::isinf(value))
+    {
+        key += 'i';
+
+        return;
+    }
+
+    int exponent;
+    const auto mantissa{ std::frexp(std::abs(value), &exponent) };
+
+    appendToCacheKey(key, (uint64_t)(int64_t)exponent);
+    appendToCacheKey(key, (uint64_t)std::ldexp(mantissa, 64));
 }
 
-inline long double Interval::getSize() const
+template<typename Real>
+BasicInterval<Real>::BasicInterval()
+    : size{ 1 }
+    , weight{ 1 }
 {
-    return size;
 }
 
-inline long double Interval::getWeight() const
+template<typename Real>
+BasicInterval<Real>::BasicInterval(const Real& s, const Real& w)
+    : size{ clampToLimits<Real>(s) }
+    , weight{ clampToLimits<Real>(w) }
 {
-    return weight;
+    manageZeroWeight();
 }
 
-void Interval::setSize(const long double& newSize)
+template<typename Real>
+void BasicInterval<Real>::setSize(const Real& newSize)
 {
-    size = clampLongDoubleToLimits(newSize);
+    size = clampToLimits<Real>(newSize);
 }
 
-void Interval::setWeight(const long double& newWeight)
+template<typename Real>
+void BasicInterval<Real>::setWeight(const Real& newWeight)
 {
-    weight = clampLongDoubleToLimits(newWeight);
+    weight = clampToLimits<Real>(newWeight);
     manageZeroWeight();
 }
 
-void Interval::setInterval(const long double& newSize, const long double& newWeight)
+template<typename Real>
+void BasicInterval<Real>::setInterval(const Real& newSize, const Real& newWeight)
 {
     setSize(newSize);
     setWeight(newWeight);
 }
 
-void Interval::manageZeroWeight()
+template<typename Real>
+void BasicInterval<Real>::manageZeroWeight()
 {
     if (weight <= 0)
-        weight = std::numeric_limits<long double>::lowest();
+        weight = std::numeric_limits<Real>::lowest();
 }
 
-Scale::Scale()
+template<typename Real>
+BasicScale<Real>::BasicScale()
 {
 }
 
-Scale::Scale(const std::string& n)
+template<typename Real>
+BasicScale<Real>::BasicScale(const std::string& n)
     : name(n)
 {
 }
 
-Scale::Scale(const IntervalsPattern& i)
-    : intervalsPattern(patternHasTriangularDimensions(i) ? i : IntervalsPattern{})
+template<typename Real>
+BasicScale<Real>::BasicScale(const IntervalsPattern& i)
+    : intervalsPattern(convertIntervalsPattern(i))
 {
     normaliseWeights();
+    cacheIntervalMatrix();
 }
 
-Scale::Scale(const IntervalsPattern& i, const std::string& n)
-    : intervalsPattern(patternHasTriangularDimensions(i) ? i : IntervalsPattern{})
+template<typename Real>
+BasicScale<Real>::BasicScale(const IntervalsPattern& i, const std::string& n)
+    : intervalsPattern(convertIntervalsPattern(i))
     , name(n)
 {
     normaliseWeights();
+    cacheIntervalMatrix();
 }
 
-inline size_t Scale::size() const
+template<typename Real>
+void BasicScale<Real>::setIntervalsPattern(const IntervalsPattern& newIntervalsPattern)
 {
-    return intervalsPattern.size() + 1;
-}
-
-void Scale::setIntervalsPattern(const IntervalsPattern& newIntervalsPattern)
-{
-    if (patternHasTriangularDimensions(newIntervalsPattern))
+    if (isValidIntervalsPattern(newIntervalsPattern))
     {
-        intervalsPattern = newIntervalsPattern;
+        intervalsPattern = convertIntervalsPattern(newIntervalsPattern);
 
         normaliseWeights();
+        cacheIntervalMatrix();
         setDummyIndecies({});
     }
 }
 
-void Scale::setDummyIndecies(const std::vector<int>& newDummyIndecies)
+template<typename Real>
+void BasicScale<Real>::setDummyIndecies(const std::vector<int>& newDummyIndecies)
 {
     if (!newDummyIndecies.empty() && *std::min_element(newDummyIndecies.begin(), newDummyIndecies.end()) < 0)
         return;
@@ -94,20 +276,46 @@ void Scale::setDummyIndecies(const std::vector<int>& newDummyIndecies)
     std::sort(dummyIndecies.begin(), dummyIndecies.end());
 }
 
-void Scale::setName(const std::string& newName)
+template<typename Real>
+void BasicScale<Real>::setName(const std::string& newName)
 {
     name = newName;
 }
 
-inline std::string Scale::getName() const
+template<typename Real>
+bool BasicScale<Real>::isValidIntervalsPattern(const IntervalsPattern& pattern)
 {
-    return name;
+    return patternHasTriangularDimensions(pattern) && pattern.size() < maxMidiNotes;
+}
+
+template<typename Real>
+BasicIntervalsPattern<Real> BasicScale<Real>::convertIntervalsPattern(const IntervalsPattern& pattern)
+{
+    if (!isValidIntervalsPattern(pattern))
+        return {};
+
+    BasicIntervalsPattern<Real> convertedPattern;
+    convertedPattern.reserve(pattern.size());
+
+    for (const auto& row : pattern)
+    {
+        std::vector<BasicInterval<Real>> convertedRow;
+        convertedRow.reserve(row.size());
+
+        for (const auto& interval : row)
+            convertedRow.push_back({ (Real)interval.getSize(), (Real)interval.getWeight() });
+
+        convertedPattern.push_back(convertedRow);
+    }
+
+    return convertedPattern;
 }
 
-Interval Scale::getInterval(const int& noteTo, const int& noteFrom) const
+template<typename Real>
+BasicInterval<Real> BasicScale<Real>::getInterval(const int& noteTo, const int& noteFrom) const
 {
     if (noteFrom > noteTo)
-        return { 1L / intervalsPattern[noteTo][noteFrom - noteTo - 1].getSize(),
+        return { Real(1) / intervalsPattern[noteTo][noteFrom - noteTo - 1].getSize(),
                  intervalsPattern[noteTo][noteFrom - noteTo - 1].getWeight() };
 
     if (noteTo == noteFrom)
@@ -116,7 +324,8 @@ Interval Scale::getInterval(const int& noteTo, const int& noteFrom) const
     return intervalsPattern[noteFrom][noteTo - noteFrom - 1];
 }
 
-long double Scale::getMinWeight() const
+template<typename Real>
+Real BasicScale<Real>::getMinWeight() const
 {
     auto minWeight{ intervalsPattern[0][0].getWeight() };
     for (const auto& row : intervalsPattern)
@@ -127,7 +336,8 @@ long double Scale::getMinWeight() const
     return minWeight;
 }
 
-long double Scale::getMaxWeight() const
+template<typename Real>
+Real BasicScale<Real>::getMaxWeight() const
 {
     auto maxWeight{ intervalsPattern[0][0].getWeight() };
     for (const auto& row : intervalsPattern)
@@ -138,124 +348,1153 @@ long double Scale::getMaxWeight() const
     return maxWeight;
 }
 
-std::vector<double> Scale::tuneScale(const int& trueRootNote, const long double& weightCutoff) const
+template<typename Real>
+std::vector<double> BasicScale<Real>::tuneScale(const int& trueRootNote, const long double& weightCutoff) const
+{
+    TuningSettings settings;
+    settings.weightCutoff = weightCutoff;
+
+    return tuneScale(trueRootNote, settings);
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::tuneScale(const int& trueRootNote, const TuningSettings& settings) const
+{
+    return tuneScaleWithStatistics(trueRootNote, settings, nullptr);
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::tuneScale(const int& trueRootNote, const TuningSettings& settings,
+                                                TuningStatistics& statistics) const
+{
+    statistics = {};
+
+    return tuneScaleWithStatistics(trueRootNote, settings, &statistics);
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::resumeTuneScale(const int& trueRootNote, const TuningSettings& settings) const
 {
-    auto tunings{ makePopulatedTunings(weightCutoff) };
+    std::error_code error;
+
+    if (settings.checkpointPath.empty() || !std::filesystem::exists(settings.checkpointPath, error))
+        return tuneScale(trueRootNote, settings);
+
+    const auto checkpoint{ PartialTunings::readFile(settings.checkpointPath) };
+
+    if (!checkpoint.has_value() || checkpoint->key != makeCacheKey(settings) || checkpoint->noteCount != size())
+        return {};
+
+    return tuneScaleWithStatistics(trueRootNote, settings, nullptr, &checkpoint.value());
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::tuneScaleWithStatistics(const int& trueRootNote, const TuningSettings& settings,
+                                                              TuningStatistics* statistics,
+                                                              const PartialTunings* checkpoint) const
+{
+    const auto start{ std::chrono::steady_clock::now() };
+
+    if constexpr (!tuningStatisticsEnabled)
+        statistics = nullptr;
+
+    std::vector<std::vector<Real>> tunings;
+
+    const auto isCheckpointed{ !settings.checkpointPath.empty() };
+    const auto cacheKey{ settings.cache != nullptr || isCheckpointed ? makeCacheKey(settings) : std::string() };
+    const auto cachedTunings{ settings.cache != nullptr ? settings.cache->find(cacheKey) : std::nullopt };
+
+    if (cachedTunings.has_value() && cachedTunings->size() == size())
+    {
+        tunings.assign(size(), std::vector<Real>(size()));
+
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+            std::copy(cachedTunings.value()[rootNote].begin(), cachedTunings.value()[rootNote].end(),
+                      tunings[rootNote].begin());
+
+        if (statistics != nullptr)
+            statistics->fromCache = true;
+    }
+    else
+    {
+        if (isCheckpointed)
+            tunings = makeCheckpointedTunings(settings, statistics,
+                                              checkpoint != nullptr ? *checkpoint : PartialTunings(cacheKey, size()));
+        else
+            tunings = makePopulatedTunings(settings, nullptr, statistics);
+
+        if (isCancelled(settings))
+            return {};
+
+        if (settings.cache != nullptr)
+        {
+            std::vector<std::vector<long double>> tuningsToCache(size());
+
+            for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+                tuningsToCache[rootNote].assign(tunings[rootNote].begin(), tunings[rootNote].end());
+
+            settings.cache->insert(cacheKey, tuningsToCache);
+        }
+    }
 
     auto tuning{ normaliseTuningsAndMakeAverageTuning(tunings, trueRootNote) };
 
+    if (statistics != nullptr)
+    {
+        statistics->collected = true;
+        statistics->aggregate();
+        statistics->wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
     return insertDummyNotes(tuning);
 }
 
-long double Scale::sumWeights(const int& noteTo, std::vector<int>& notesFrom) const
+template<typename Real>
+TuningEstimate BasicScale<Real>::estimateTuning(const int& trueRootNote, const TuningSettings& settings) const
 {
-    long double sum{ 0 };
+    std::vector<std::vector<Real>> logVariances(size(), std::vector<Real>(size(), 0));
 
-    for (auto& noteFrom : notesFrom)
-        sum += getInterval(noteTo, noteFrom).getWeight();
+    auto tunings{ makePopulatedTunings(settings, &logVariances) };
 
-    return sum;
+    if (isCancelled(settings))
+        return {};
+
+    auto tuning{ normaliseTuningsAndMakeAverageTuning(tunings, trueRootNote) };
+
+    //the tuning of a note is the mean over root notes of its log tuning, less that of trueRootNote for
+    //root notes which normaliseTuningsAndMakeAverageTuning() normalises
+    std::vector<double> standardErrors(size(), 0);
+
+    for (auto note{ 0 }; note != size(); ++note)
+    {
+        Real logVariance{ 0 };
+
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+        {
+            logVariance += logVariances[rootNote][note];
+
+            if (rootNote != 0 && rootNote != trueRootNote && note != trueRootNote)
+                logVariance += logVariances[rootNote][trueRootNote];
+        }
+
+        standardErrors[note] = 1200 * std::sqrt((double)logVariance) / (double)size();
+    }
+
+    return { insertDummyNotes(tuning), insertDummyNotes(standardErrors) };
 }
 
-long double Scale::makeTuning(const int& rootNote, int& note, const long double& weightCutoff) const
+template<typename Real>
+EngineComparison BasicScale<Real>::compareEngines(const int& trueRootNote, const TuningSettings& settings,
+                                                  const TuningEngine& baselineEngine,
+                                                  const TuningEngine& candidateEngine) const
 {
-    long double tunedNote{ 1 };
+    auto timeTuning{ [&, this](const TuningEngine& engine, std::vector<double>& tuning) -> double
+        {
+            auto engineSettings{ settings };
+            engineSettings.engine = engine;
+            //each engine's tuning would otherwise replace the checkpoint with its own
+            engineSettings.checkpointPath.clear();
 
-    long double adjustmentFactor{ 1 };
-    bool adjustmentFactorWasSet{ false };
+            const auto start{ std::chrono::steady_clock::now() };
+            tuning = tuneScale(trueRootNote, engineSettings);
+
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
 
-    std::vector<int> nextNotes(size());
-    std::iota(nextNotes.begin(), nextNotes.end(), 0);
-    nextNotes.erase(find(nextNotes.begin(), nextNotes.end(), note));
+    std::vector<double> baselineTuning, candidateTuning;
 
-    const auto firstRollingWeight{ 1 / sumWeights(note, nextNotes) };
+    EngineComparison comparison;
+    comparison.baselineSeconds = timeTuning(baselineEngine, baselineTuning);
+    comparison.candidateSeconds = timeTuning(candidateEngine, candidateTuning);
+    comparison.speedup = comparison.baselineSeconds / comparison.candidateSeconds;
+    comparison.maxCentsDifference = maxCentsDifference(baselineTuning, candidateTuning);
 
-    return traverseScale(note, nextNotes, rootNote, firstRollingWeight, weightCutoff, firstRollingWeight);
+    return comparison;
 }
 
-long double Scale::traverseScale(int& lastNote, std::vector<int>& possibleNextNotesInPath,
-    const int& rootNote, const long double& rollingWeight, const long double& weightCutoff,
-    const long double& possibleWeightsToNoteSum) const
+template<typename Real>
+AnytimeTuning BasicScale<Real>::tuneScaleUntil(const int& trueRootNote, const TuningSettings& settings,
+                                               const std::chrono::steady_clock::time_point& deadline) const
 {
-    long double returnValue{ 1 };
+    const auto pairCount{ size() * size() };
+
+    //the log tuning of each pair from the last pass which finished it, and the share of the weight of its
+    //paths that pass cut. Until a pass has finished it, every path is treated as going straight to the
+    //root note
+    std::vector<Real> pairLogTunings(pairCount, 0);
+    std::vector<Real> unexploredMasses(pairCount, 1);
+
+    for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+    {
+        for (auto note{ 0 }; note != size(); ++note)
+            pairLogTunings[rootNote * size() + note] = intervalMatrix.logSizes[note * size() + rootNote];
+
+        unexploredMasses[rootNote * size() + rootNote] = 0;
+    }
+
+    auto isOutOfTime{ [&]()
+        {
+            return std::chrono::steady_clock::now() >= deadline || isCancelled(settings);
+        }
+    };
+
+    //the same of the pass being run, and the number of steps it took for each pair
+    std::vector<Real> passLogTunings(pairCount, 0);
+    std::vector<Real> passCutMasses(pairCount, 0);
+    std::vector<size_t> passStepCounts(pairCount, 0);
+    std::atomic<bool> isPassInterrupted{ false };
+
+    auto traversePair{ [&, this](const size_t& pair, const long double& weightCutoff)
+        {
+            if (isPassInterrupted || isOutOfTime())
+            {
+                isPassInterrupted = true;
+                return;
+            }
+
+            ScaleTraversal<Real> traversal(intervalMatrix, (int)(pair / size()), (int)(pair % size()), (Real)weightCutoff,
+                                           0, true);
+
+            while (!traversal.run(anytimeDeadlineCheckSteps))
+                if (isPassInterrupted || isOutOfTime())
+                {
+                    isPassInterrupted = true;
+                    return;
+                }
 
-    for (auto nextNoteIndex{ 0 }; nextNoteIndex != possibleNextNotesInPath.size(); ++nextNoteIndex)
+            passLogTunings[pair] = traversal.getLogTuning();
+            passCutMasses[pair] = traversal.getCutMass();
+            passStepCounts[pair] = traversal.getStepCount();
+        }
+    };
+
+    //each pass is planned from the time per step of the pass before it and the growth of the number of
+    //steps as the cutoff falls measured by the two before it. Passes grow from a cheap first pass to
+    //measure these, and then one is planned to take most of the time left. A pass which finishes replaces
+    //the tunings, and one the deadline interrupts replaces those of the pairs it finished
+    auto weightCutoff{ std::max(anytimeFirstWeightCutoff, settings.weightCutoff) };
+    double lastLogCutoff{ 0 };
+    double lastStepCount{ 0 };
+    auto isComplete{ false };
+
+    while (!isComplete)
     {
-        const auto nextNote{ possibleNextNotesInPath[nextNoteIndex] };
-        const auto nextInterval{ getInterval(lastNote, nextNote) };
+        const auto passStart{ std::chrono::steady_clock::now() };
+        std::fill(passStepCounts.begin(), passStepCounts.end(), 0);
 
-        if (nextNote == rootNote || nextInterval.getWeight() * rollingWeight <= weightCutoff)
-            returnValue *= std::pow(getInterval(lastNote, rootNote).getSize(), nextInterval.getWeight() * possibleWeightsToNoteSum);
+        if (settings.threadPool == nullptr)
+        {
+            for (size_t pair{ 0 }; pair != pairCount; ++pair)
+                if (pair / size() != pair % size())
+                    traversePair(pair, weightCutoff);
+        }
         else
         {
-            const auto initialLastNote{ lastNote };
+            TaskGroup tasks(*settings.threadPool);
+
+            for (size_t pair{ 0 }; pair != pairCount; ++pair)
+                if (pair / size() != pair % size())
+                    tasks.run([&traversePair, pair, weightCutoff]() { traversePair(pair, weightCutoff); });
+
+            tasks.wait();
+        }
+
+        const auto passEnd{ std::chrono::steady_clock::now() };
+
+        for (size_t pair{ 0 }; pair != pairCount; ++pair)
+            if (passStepCounts[pair] != 0)
+            {
+                pairLogTunings[pair] = passLogTunings[pair];
+                unexploredMasses[pair] = passCutMasses[pair];
+            }
+
+        if (isPassInterrupted)
+            break;
+
+        //once a pass cuts nothing, so would every pass after it
+        isComplete = weightCutoff == settings.weightCutoff ||
+                     std::all_of(unexploredMasses.begin(), unexploredMasses.end(), [](const Real& mass) { return mass == 0; });
+
+        const auto stepCount{ (double)std::max<size_t>(1, std::accumulate(passStepCounts.begin(), passStepCounts.end(),
+                                                                           size_t(0))) };
+        const auto logCutoff{ -std::log((double)weightCutoff) };
+        const auto passSeconds{ std::max(std::chrono::duration<double>(passEnd - passStart).count(), 1e-9) };
+        const auto secondsLeft{ std::chrono::duration<double>(deadline - passEnd).count() };
+
+        auto plannedSeconds{ std::min(passSeconds * anytimePassGrowth, secondsLeft * anytimeCalibrationShare) };
+
+        if (lastStepCount > 0 && passSeconds * 2 >= secondsLeft * anytimeCalibrationShare)
+            plannedSeconds = secondsLeft * anytimeLastPassTimeShare;
+
+        auto growthExponent{ anytimeDefaultGrowthExponent };
+
+        if (lastStepCount > 0)
+            growthExponent = std::clamp(std::log(stepCount / lastStepCount) / (logCutoff - lastLogCutoff),
+                                        anytimeMinGrowthExponent, anytimeMaxGrowthExponent);
+
+        //the cutoff with which the next pass is predicted to take the time planned for it. One which isn't
+        //planned to finish is still run, as the pairs it finishes improve the tuning
+        const auto stepGrowth{ std::max(plannedSeconds / passSeconds, 1.0) };
+
+        lastLogCutoff = logCutoff;
+        lastStepCount = stepCount;
+        weightCutoff = std::min(weightCutoff * anytimeMaxCutoffRatio,
+                                weightCutoff * (long double)std::pow(stepGrowth, -1 / growthExponent));
+        weightCutoff = std::max(weightCutoff, settings.weightCutoff);
+    }
+
+    AnytimeTuning anytimeTuning;
+    anytimeTuning.complete = isComplete;
 
-            lastNote = nextNote;
-            possibleNextNotesInPath.erase(possibleNextNotesInPath.begin() + nextNoteIndex);
+    std::vector<std::vector<Real>> tunings(size(), std::vector<Real>(size(), 1));
+    std::vector<double> coverage(size(), 1);
+
+    for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+        for (auto note{ 0 }; note != size(); ++note)
+            if (rootNote != note)
+            {
+                tunings[rootNote][note] = clampToLimits<Real>(
+                    SiblingKernels::approximateExp2(pairLogTunings[rootNote * size() + note], settings.approximationAccuracy));
+                coverage[note] -= std::clamp<double>(unexploredMasses[rootNote * size() + note], 0, 1) / (double)(size() - 1);
+            }
 
-            const auto sumWeightsToNextNote{ 1 / sumWeights(nextNote, possibleNextNotesInPath) };
+    auto tuning{ normaliseTuningsAndMakeAverageTuning(tunings, trueRootNote) };
 
-            returnValue *= std::pow(nextInterval.getSize() * traverseScale(lastNote,
-                                                                           possibleNextNotesInPath,
-                                                                           rootNote,
-                                                                           clampLongDoubleToLimits(nextInterval.getWeight() *
-                                                                                                   rollingWeight *
-                                                                                                   sumWeightsToNextNote),
-                                                                           weightCutoff,
-                                                                           sumWeightsToNextNote),
-                                    nextInterval.getWeight() * possibleWeightsToNoteSum);
+    anytimeTuning.tuning = insertDummyNotes(tuning);
+    anytimeTuning.coverage = insertDummyNotes(coverage);
+
+    return anytimeTuning;
+}
+
+template<typename Real>
+PartialTunings BasicScale<Real>::tuneShard(const size_t& shardIndex, const size_t& shardCount,
+                                           const TuningSettings& settings) const
+{
+    PartialTunings shard(makeCacheKey(settings), size());
+
+    if (shardIndex >= shardCount)
+        return shard;
+
+    //jobs are dealt out in the order they are tuned, so that neighbouring notes, which take a similar time,
+    //go to different shards
+    auto isInShard{ [&, this](const int& rootNote, const int& note)
+        {
+            return (note == -1 ? rootNote : rootNote * size() + note) % shardCount == shardIndex;
+        }
+    };
 
-            possibleNextNotesInPath.insert(possibleNextNotesInPath.begin() + nextNoteIndex, lastNote);
-            lastNote = initialLastNote;
+    //each job writes only the elements of its own pairs
+    auto recordJob{ [&, this](const int& rootNote, const int& note, const std::vector<Real>& rootNoteTunings)
+        {
+            recordTunedJob(shard, rootNote, note, rootNoteTunings);
         }
+    };
+
+    makePopulatedTunings(settings, nullptr, nullptr, isInShard, recordJob);
+
+    return shard;
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::mergeShards(const std::vector<PartialTunings>& shards, const int& trueRootNote,
+                                                  const TuningSettings& settings) const
+{
+    PartialTunings mergedShards(makeCacheKey(settings), size());
+
+    for (const auto& shard : shards)
+        if (!mergedShards.add(shard))
+            return {};
+
+    if (!mergedShards.isComplete())
+        return {};
+
+    std::vector<std::vector<Real>> tunings(size(), std::vector<Real>(size()));
+
+    for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+        for (auto note{ 0 }; note != size(); ++note)
+            tunings[rootNote][note] = (Real)mergedShards.tunings[rootNote * size() + note];
+
+    if (settings.cache != nullptr)
+    {
+        std::vector<std::vector<long double>> tuningsToCache(size());
+
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+            tuningsToCache[rootNote].assign(tunings[rootNote].begin(), tunings[rootNote].end());
+
+        settings.cache->insert(mergedShards.key, tuningsToCache);
     }
 
-    return returnValue;
+    auto tuning{ normaliseTuningsAndMakeAverageTuning(tunings, trueRootNote) };
+
+    return insertDummyNotes(tuning);
 }
 
-std::vector<std::vector<long double>> Scale::makePopulatedTunings(const long double& weightCutoff) const
+template<typename Real>
+RuntimeEstimate BasicScale<Real>::estimateRuntime(const TuningSettings& settings, const size_t& probesPerPair) const
 {
-    auto percentTuned{ [this](int& rootNote, int& note) -> long double
+    double variance;
+
+    RuntimeEstimate estimate;
+    estimate.weightCutoff = settings.weightCutoff;
+    estimate.nodeCount = estimateNodeCount(settings, probesPerPair, variance);
+    estimate.nodeCountStandardError = std::sqrt(variance);
+    estimate.seconds = estimate.nodeCount * measureSecondsPerNode(settings, probesPerPair);
+
+    return estimate;
+}
+
+template<typename Real>
+std::optional<long double> BasicScale<Real>::chooseWeightCutoff(const std::chrono::duration<double>& budget,
+                                                                const TuningSettings& settings,
+                                                                const size_t& probesPerPair) const
+{
+    const auto secondsPerNode{ measureSecondsPerNode(settings, probesPerPair) };
+
+    auto fitsBudget{ [&, this](const long double& weightCutoff)
         {
-            return (((long double)rootNote / (long double)size())
-                + ((long double)note / ((long double)size() * (long double)size()))) * 100;
+            auto cutoffSettings{ settings };
+            cutoffSettings.weightCutoff = weightCutoff;
+
+            double variance;
+
+            return estimateNodeCount(cutoffSettings, probesPerPair, variance) * secondsPerNode <= budget.count();
         }
     };
 
-    std::vector<std::vector<long double>> tunings(size(), std::vector<long double>(size()));
+    if (fitsBudget(0))
+        return 0;
+
+    if (!fitsBudget(1))
+        return std::nullopt;
+
+    //the number of nodes grows as the cutoff falls, so the cutoff is bracketed a power of 10 at a time and
+    //then bisected between its logarithms
+    long double fittingCutoff{ 1 };
+    long double failingCutoff{ 0.1L };
+
+    for (auto power{ 1 }; fitsBudget(failingCutoff); ++power)
+    {
+        if (power == std::numeric_limits<long double>::max_exponent10)
+            return failingCutoff;
+
+        fittingCutoff = failingCutoff;
+        failingCutoff /= 10;
+    }
+
+    for (auto bisection{ 0 }; bisection != 8; ++bisection)
+    {
+        const auto cutoff{ std::sqrt(fittingCutoff * failingCutoff) };
+
+        if (fitsBudget(cutoff))
+            fittingCutoff = cutoff;
+        else
+            failingCutoff = cutoff;
+    }
+
+    return fittingCutoff;
+}
+
+template<typename Real>
+ScaleTraversal<Real> BasicScale<Real>::makeTraversal(const int& rootNote, const int& note,
+                                                     const long double& weightCutoff,
+                                                     const double& maxCentsError) const
+{
+    //a note's tuning is the difference of two log tunings, so each may use half of the error
+    return ScaleTraversal<Real>(intervalMatrix, rootNote, note, (Real)weightCutoff, (Real)(maxCentsError / 2400));
+}
+
+template<typename Real>
+std::string BasicScale<Real>::makeCacheKey(const TuningSettings& settings) const
+{
+    std::string key{ "populated tunings" };
+
+    appendToCacheKey(key, (uint64_t)std::numeric_limits<Real>::digits);
+    appendToCacheKey(key, (uint64_t)settings.engine);
+    appendToCacheKey(key, (uint64_t)settings.approximationAccuracy);
+    appendToCacheKey(key, settings.weightCutoff);
+    appendToCacheKey(key, (long double)settings.maxCentsError);
+
+    if (settings.engine == TuningEngine::monteCarlo)
+    {
+        appendToCacheKey(key, (uint64_t)settings.sampleBudget);
+        appendToCacheKey(key, settings.samplingSeed);
+    }
+
+    appendToCacheKey(key, (uint64_t)size());
+
+    for (const auto& row : intervalsPattern)
+        for (const auto& interval : row)
+        {
+            appendToCacheKey(key, (long double)interval.getSize());
+            appendToCacheKey(key, (long double)interval.getWeight());
+        }
+
+    auto sortedDummyIndecies{ dummyIndecies };
+    std::sort(sortedDummyIndecies.begin(), sortedDummyIndecies.end());
 
-    long double lastPercentage{ 0 };
-    const long double loadingInterval{ 0.1 };
+    appendToCacheKey(key, (uint64_t)sortedDummyIndecies.size());
 
-    std::cout << "Tuning " << name << std::endl << std::endl;
-    std::cout << std::fixed << std::setprecision(1) << "Progress: 0.0% \r";
+    for (const auto& index : sortedDummyIndecies)
+        appendToCacheKey(key, (uint64_t)(int64_t)index);
+
+    return key;
+}
+
+template<typename Real>
+double BasicScale<Real>::estimateNodeCount(const TuningSettings& settings, const size_t& probesPerPair,
+                                           double& variance) const
+{
+    variance = 0;
+
+    if (settings.engine == TuningEngine::monteCarlo)
+        return (double)std::max<size_t>(2, settings.sampleBudget / std::max<size_t>(1, size() * (size() - 1))) *
+               (double)(size() * (size() - 1));
+
+    //exactSubsets calculates every entry of the memo table of every root note
+    if (usesExactSubsets(settings))
+        return (double)size() * (double)(size() - 1) * std::ldexp(1.0, (int)size() - 2);
+
+    double nodeCount{ 0 };
 
     for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
         for (auto note{ 0 }; note != size(); ++note)
+            if (note != rootNote)
+            {
+                double pairVariance;
+
+                nodeCount += makeTraversal(rootNote, note, settings.weightCutoff)
+                    .estimateNodeCount(probesPerPair, PathSampler<Real>::pairSeed(settings.samplingSeed, rootNote, note),
+                                       pairVariance);
+                variance += pairVariance;
+            }
+
+    return nodeCount;
+}
+
+template<typename Real>
+double BasicScale<Real>::measureSecondsPerNode(const TuningSettings& settings, const size_t& probesPerPair) const
+{
+    auto calibrationSettings{ settings };
+    calibrationSettings.progressCallback = {};
+    calibrationSettings.silent = true;
+    calibrationSettings.cache = nullptr;
+    calibrationSettings.checkpointPath.clear();
+    //the node count is estimated for the traversal weightCutoff prunes, so that is the one timed
+    calibrationSettings.maxCentsError = 0;
+
+    if (settings.engine == TuningEngine::monteCarlo)
+        calibrationSettings.sampleBudget = std::min<size_t>(settings.sampleBudget, (size_t)calibrationNodeCount);
+    else
+    {
+        //the largest cutoff, falling a quarter of a power of 10 at a time, whose tuning enters enough nodes,
+        //which only needs to be roughly sized
+        const auto searchProbesPerPair{ std::min<size_t>(probesPerPair, 16) };
+
+        for (auto step{ 0 }; step != 4 * std::numeric_limits<double>::max_exponent10; ++step)
+        {
+            calibrationSettings.weightCutoff = std::pow(10.0L, -step / 4.0L);
+
+            double variance;
+
+            if (calibrationSettings.weightCutoff <= settings.weightCutoff ||
+                estimateNodeCount(calibrationSettings, searchProbesPerPair, variance) >= calibrationNodeCount)
+                break;
+        }
+
+        calibrationSettings.weightCutoff = std::max(calibrationSettings.weightCutoff, settings.weightCutoff);
+    }
+
+    double variance;
+    const auto nodeCount{ std::max(1.0, estimateNodeCount(calibrationSettings, probesPerPair, variance)) };
+
+    //the faster of two tunings, as the first also fills each thread's working memory
+    auto seconds{ std::numeric_limits<double>::max() };
+
+    for (auto run{ 0 }; run != 2; ++run)
+    {
+        const auto start{ std::chrono::steady_clock::now() };
+        tuneScale(0, calibrationSettings);
+
+        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return seconds / nodeCount;
+}
+
+template<typename Real>
+Real BasicScale<Real>::sumWeights(const int& noteTo, const NoteSet& notesFrom) const
+{
+    Real sum{ 0 };
+
+    const auto* weightsToNote{ &intervalMatrix.weights[noteTo * size()] };
+
+    for (auto remainingNotes{ notesFrom }; !remainingNotes.empty();)
+        sum += weightsToNote[remainingNotes.popFirst()];
+
+    return sum;
+}
+
+template<typename Real>
+void BasicScale<Real>::removeFromRemainingWeightSums(const int& note, std::vector<Real>& remainingWeightSums) const
+{
+    //weights are symmetric, so the weights from note to every other note are a contiguous row
+    const auto* weightsToNote{ &intervalMatrix.weights[note * size()] };
+
+    for (auto otherNote{ 0 }; otherNote != size(); ++otherNote)
+        remainingWeightSums[otherNote] -= weightsToNote[otherNote];
+}
+
+template<typename Real>
+void BasicScale<Real>::restoreToRemainingWeightSums(const int& note, std::vector<Real>& remainingWeightSums) const
+{
+    const auto* weightsToNote{ &intervalMatrix.weights[note * size()] };
+
+    for (auto otherNote{ 0 }; otherNote != size(); ++otherNote)
+        remainingWeightSums[otherNote] += weightsToNote[otherNote];
+}
+
+template<typename Real>
+Real BasicScale<Real>::makeTuning(const int& rootNote, int& note, const TuningSettings& settings) const
+{
+    const auto& accuracy{ settings.approximationAccuracy };
+
+    if (settings.engine == TuningEngine::logarithmic || settings.engine == TuningEngine::exactSubsets ||
+        settings.maxCentsError > 0)
+    {
+        //traversals are run in slices so that cancellation is noticed part way through
+        auto runTraversal{ [&settings](ScaleTraversal<Real>& traversal)
+            {
+                while (!traversal.run(cancellationCheckSteps))
+                    if (isCancelled(settings))
+                        return;
+            }
+        };
+
+        auto traversal{ makeTraversal(rootNote, note, settings.weightCutoff, settings.maxCentsError) };
+
+        TuningCounters::countPow();
+
+        if (settings.threadPool == nullptr || settings.subtreeSplitDepth == 0)
+        {
+            runTraversal(traversal);
+
+            return clampToLimits<Real>(SiblingKernels::approximateExp2(traversal.getLogTuning(), accuracy));
+        }
+
+        auto subtrees{ traversal.split(settings.subtreeSplitDepth) };
+
+        //each subtree counts into its own statistics, which are added to the pair's once every subtree is run
+        auto* jobStatistics{ TuningCounters::currentJob() };
+        std::vector<TuningJobStatistics> subtreeStatistics(jobStatistics != nullptr ? subtrees.size() : 0);
+
+        TaskGroup tasks(*settings.threadPool);
+
+        for (auto subtree{ 0 }; subtree != subtrees.size(); ++subtree)
+            tasks.run([&runTraversal, &subtrees, &subtreeStatistics, subtree]()
+                {
+                    std::optional<TuningCounters::Scope> countingScope;
+
+                    if (!subtreeStatistics.empty())
+                        countingScope.emplace(subtreeStatistics[subtree]);
+
+                    runTraversal(subtrees[subtree].traversal);
+                });
+
+        tasks.wait();
+
+        for (const auto& statistics : subtreeStatistics)
+            jobStatistics->add(statistics);
+
+        //combined in a fixed order so that the result does not depend on which task finished first
+        auto logTuning{ traversal.getLogTuning() };
+
+        for (const auto& subtree : subtrees)
+            logTuning += subtree.coefficient * subtree.traversal.getLogTuning();
+
+        return clampToLimits<Real>(SiblingKernels::approximateExp2(logTuning, accuracy));
+    }
+
+    auto nextNotes{ NoteSet::firstNotes(size()) };
+    nextNotes.erase(note);
+
+    auto& remainingWeightSums{ traversalScratch<Real>().remainingWeightSums };
+    remainingWeightSums.resize(size());
+
+    for (auto otherNote{ 0 }; otherNote != size(); ++otherNote)
+        remainingWeightSums[otherNote] = sumWeights(otherNote, nextNotes);
+
+    const auto firstRollingWeight{ 1 / remainingWeightSums[note] };
+
+    if (accuracy != ApproximationAccuracy::exact)
+    {
+        traversalScratch<Real>().siblingWeights.resize(size() * size());
+        traversalScratch<Real>().siblingSizes.resize(size() * size());
+    }
+
+    return traverseScale(note, nextNotes, remainingWeightSums, rootNote, firstRollingWeight,
+                         (Real)settings.weightCutoff, firstRollingWeight, settings);
+}
+
+template<typename Real>
+Real BasicScale<Real>::sampleTuning(const int& rootNote, const int& note, const TuningSettings& settings,
+                                   Real& logVariance) const
+{
+    const auto pairCount{ std::max<size_t>(1, size() * (size() - 1)) };
+    const auto sampleCount{ std::max<size_t>(2, settings.sampleBudget / pairCount) };
+
+    PathSampler<Real> sampler(intervalMatrix, rootNote, note, (Real)settings.weightCutoff,
+                              PathSampler<Real>::pairSeed(settings.samplingSeed, rootNote, note));
+
+    //paths are sampled in slices so that cancellation is noticed part way through
+    while (sampler.getSampleCount() != sampleCount && !isCancelled(settings))
+        sampler.sample(std::min(cancellationCheckSteps, sampleCount - sampler.getSampleCount()));
+
+    logVariance = sampler.getMeanLogTuningVariance();
+
+    TuningCounters::countPow();
+
+    return clampToLimits<Real>(SiblingKernels::approximateExp2(sampler.getMeanLogTuning(),
+                                                               settings.approximationAccuracy));
+}
+
+template<typename Real>
+Real BasicScale<Real>::traverseScale(int& lastNote, NoteSet& possibleNextNotesInPath,
+    std::vector<Real>& remainingWeightSums, const int& rootNote, const Real& rollingWeight,
+    const Real& weightCutoff, const Real& possibleWeightsToNoteSum, const TuningSettings& settings) const
+{
+    if (isCancelled(settings))
+        return 1;
+
+    const auto& accuracy{ settings.approximationAccuracy };
+
+    Real returnValue{ 1 };
+
+    const auto* sizesToLastNote{ &intervalMatrix.sizes[lastNote * size()] };
+    const auto* logSizesToLastNote{ &intervalMatrix.logSizes[lastNote * size()] };
+    const auto* weightsToLastNote{ &intervalMatrix.weights[lastNote * size()] };
+
+    const auto siblings{ SiblingKernels::partitionSiblings(weightsToLastNote, size(), possibleNextNotesInPath,
+                                                           rootNote, rollingWeight, weightCutoff) };
+
+    //every pruned sibling contributes a power of the interval to rootNote, so they share one exponent
+    auto exponent{ logSizesToLastNote[rootNote] * siblings.prunedWeightSum };
+
+    //when approximating, traversed siblings are gathered so their logs can be taken together
+    const auto depth{ size() - 1 - possibleNextNotesInPath.size() };
+
+    if constexpr (tuningStatisticsEnabled)
+    {
+        TuningCounters::countNode(depth, possibleNextNotesInPath.size() - siblings.notesToTraverse.size(),
+                                  possibleNextNotesInPath.contains(rootNote));
+        TuningCounters::countPow(1 + (accuracy == ApproximationAccuracy::exact ? siblings.notesToTraverse.size() : 0));
+    }
+    Real* siblingWeights{ nullptr };
+    Real* siblingSizes{ nullptr };
+    size_t siblingCount{ 0 };
+
+    if (accuracy != ApproximationAccuracy::exact)
+    {
+        siblingWeights = &traversalScratch<Real>().siblingWeights[depth * size()];
+        siblingSizes = &traversalScratch<Real>().siblingSizes[depth * size()];
+    }
+
+    for (auto nextNotes{ siblings.notesToTraverse }; !nextNotes.empty();)
+    {
+        const auto nextNote{ nextNotes.popFirst() };
+        const auto nextWeight{ weightsToLastNote[nextNote] };
+        const auto initialLastNote{ lastNote };
+
+        lastNote = nextNote;
+        possibleNextNotesInPath.erase(nextNote);
+        removeFromRemainingWeightSums(nextNote, remainingWeightSums);
+
+        const auto sumWeightsToNextNote{ 1 / remainingWeightSums[nextNote] };
+
+        const auto pathSize{ sizesToLastNote[nextNote] * traverseScale(lastNote,
+                                                                       possibleNextNotesInPath,
+                                                                       remainingWeightSums,
+                                                                       rootNote,
+                                                                       clampToLimits<Real>(nextWeight *
+                                                                                           rollingWeight *
+                                                                                           sumWeightsToNextNote),
+                                                                       weightCutoff,
+                                                                       sumWeightsToNextNote,
+                                                                       settings) };
+
+        if (accuracy == ApproximationAccuracy::exact)
+            returnValue *= std::pow(pathSize, nextWeight * possibleWeightsToNoteSum);
+        else
         {
-            tunings[rootNote][note] = rootNote == note ? 1 : makeTuning(rootNote, note, weightCutoff);
+            siblingWeights[siblingCount] = nextWeight;
+            siblingSizes[siblingCount] = pathSize;
+            ++siblingCount;
+        }
+
+        restoreToRemainingWeightSums(nextNote, remainingWeightSums);
+        possibleNextNotesInPath.insert(nextNote);
+        lastNote = initialLastNote;
+    }
+
+    if (siblingCount != 0)
+        exponent += SiblingKernels::weightedLog2Sum(siblingWeights, siblingSizes, siblingCount, accuracy);
+
+    return returnValue * SiblingKernels::approximateExp2(exponent * possibleWeightsToNoteSum, accuracy);
+}
 
-            const auto percentage{ percentTuned(rootNote, note) };
+template<typename Real>
+void BasicScale<Real>::makeExactTuningsForRootNote(const int& rootNote, std::vector<Real>& rootNoteTunings,
+                                                   const CancellationToken* cancellationToken) const
+{
+    //notes other than rootNote are renumbered [0, noteCount) so that sets of them fit in noteCount bits
+    const int noteCount{ (int)size() - 1 };
+    auto scaleNote{ [&rootNote](const int& note) { return note < rootNote ? note : note + 1; } };
+
+    auto& weights{ traversalScratch<Real>().weights };
+    auto& logSizes{ traversalScratch<Real>().logSizes };
+    auto& weightsToRootNote{ traversalScratch<Real>().weightsToRootNote };
+    auto& logSizesToRootNote{ traversalScratch<Real>().logSizesToRootNote };
 
-            if (percentage - lastPercentage >= loadingInterval)
+    weights.resize(noteCount * noteCount);
+    logSizes.resize(noteCount * noteCount);
+    weightsToRootNote.resize(noteCount);
+    logSizesToRootNote.resize(noteCount);
+
+    for (auto lastNote{ 0 }; lastNote != noteCount; ++lastNote)
+    {
+        for (auto nextNote{ 0 }; nextNote != noteCount; ++nextNote)
+            if (nextNote != lastNote)
             {
-                std::cout << "Progress: " << percentage << "% \r";
-                lastPercentage = percentage;
+                weights[lastNote * noteCount + nextNote] = intervalMatrix.weights[scaleNote(lastNote) * size() + scaleNote(nextNote)];
+                logSizes[lastNote * noteCount + nextNote] = intervalMatrix.logSizes[scaleNote(lastNote) * size() + scaleNote(nextNote)];
             }
+
+        weightsToRootNote[lastNote] = intervalMatrix.weights[scaleNote(lastNote) * size() + rootNote];
+        logSizesToRootNote[lastNote] = intervalMatrix.logSizes[scaleNote(lastNote) * size() + rootNote];
+    }
+
+    //a set of remaining notes never contains lastNote, so its bit is removed to halve the memo table
+    auto removeBit{ [](const uint64_t& notes, const int& bit) -> uint64_t
+        {
+            const auto lowerBits{ (uint64_t(1) << bit) - 1 };
+
+            return (notes & lowerBits) | ((notes >> (bit + 1)) << bit);
         }
+    };
+
+    const auto allNotes{ (uint64_t(1) << noteCount) - 1 };
+    const size_t subsetCount{ size_t(1) << (noteCount - 1) };
 
-    std::cout << "Progress: 100.0% \r\n" << std::endl;
+    //the log of traverseScale() from lastNote through remainingNotes, at lastNote * subsetCount + remainingNotes,
+    //which is not kept in the thread's scratch as it can take gigabytes and is freed once the root note is tuned
+    ExactSubsetsMemoryReservation memoryReservation(noteCount * subsetCount * sizeof(Real));
+
+    if (cancellationToken != nullptr && cancellationToken->isCancelled())
+        return;
+
+    std::vector<Real> pathLogSizes(noteCount * subsetCount);
+
+    //every set of remaining notes is greater than the sets left after removing any one of its notes
+    for (uint64_t remainingNotes{ 0 }; remainingNotes <= allNotes; ++remainingNotes)
+    {
+        if ((remainingNotes % cancellationCheckSteps) == 0 && cancellationToken != nullptr &&
+            cancellationToken->isCancelled())
+            return;
+
+        for (auto lastNote{ 0 }; lastNote != noteCount; ++lastNote)
+        {
+            if ((remainingNotes >> lastNote) & 1)
+                continue;
+
+            auto weightSum{ weightsToRootNote[lastNote] };
+            auto weightedLogSizeSum{ weightsToRootNote[lastNote] * logSizesToRootNote[lastNote] };
+
+            for (auto nextNotes{ remainingNotes }; nextNotes != 0; nextNotes &= nextNotes - 1)
+            {
+                const auto nextNote{ std::countr_zero(nextNotes) };
+                const auto weight{ weights[lastNote * noteCount + nextNote] };
+                const auto notesAfterNextNote{ removeBit(remainingNotes & ~(uint64_t(1) << nextNote), nextNote) };
+
+                weightSum += weight;
+                weightedLogSizeSum += weight * (logSizes[lastNote * noteCount + nextNote] +
+                                                pathLogSizes[nextNote * subsetCount + notesAfterNextNote]);
+            }
+
+            pathLogSizes[lastNote * subsetCount + removeBit(remainingNotes, lastNote)] = weightedLogSizeSum / weightSum;
+        }
+    }
+
+    if constexpr (tuningStatisticsEnabled)
+        if (auto* statistics{ TuningCounters::currentJob() })
+        {
+            //every entry of the memo table is a node whose interval to rootNote ends a path
+            statistics->nodesVisited += noteCount * subsetCount;
+            statistics->rootLeaves += noteCount * subsetCount;
+            statistics->maxDepth = std::max<size_t>(statistics->maxDepth, noteCount - 1);
+            statistics->powCalls += noteCount;
+        }
+
+    rootNoteTunings[rootNote] = 1;
+
+    for (auto note{ 0 }; note != noteCount; ++note)
+        rootNoteTunings[scaleNote(note)] =
+            clampToLimits<Real>(std::exp2(pathLogSizes[note * subsetCount +
+                                                       removeBit(allNotes & ~(uint64_t(1) << note), note)]));
+}
+
+template<typename Real>
+std::vector<std::vector<Real>> BasicScale<Real>::makePopulatedTunings(const TuningSettings& settings,
+                                                                      std::vector<std::vector<Real>>* logVariances,
+                                                                      TuningStatistics* statistics,
+                                                                      const std::function<bool(const int&, const int&)>& isJobToTune,
+                                                                      const std::function<void(const int&, const int&,
+                                                                          const std::vector<Real>&)>& jobFinished) const
+{
+    std::vector<std::vector<Real>> tunings(size(), std::vector<Real>(size()));
+
+    const auto useExactSubsets{ usesExactSubsets(settings) };
+
+    //progress is counted in pairs, of which a whole root note is size()
+    size_t jobCount{ 0 };
+
+    for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+        if (useExactSubsets)
+            jobCount += !isJobToTune || isJobToTune(rootNote, -1) ? size() : 0;
+        else
+            for (auto note{ 0 }; note != size(); ++note)
+                jobCount += !isJobToTune || isJobToTune(rootNote, note);
+
+    std::atomic<size_t> jobsFinished{ 0 };
+
+    auto progressCallback{ settings.progressCallback };
+
+    const auto writeToConsole{ !progressCallback && !settings.silent };
+
+    if (writeToConsole)
+    {
+        std::cout << "Tuning " << name << std::endl << std::endl;
+        std::cout << std::fixed << std::setprecision(1) << "Progress: 0.0% \r";
+
+        progressCallback = [](const TuningProgress& progress)
+        {
+            std::cout << "Progress: " << (long double)progress.jobsFinished / (long double)progress.jobCount * 100
+                      << "% \r";
+        };
+    }
+
+    //a report is skipped, rather than waited for, while another thread is making one
+    std::mutex progressMutex;
+    auto lastReportTime{ std::chrono::steady_clock::now() };
+
+    auto reportProgress{ [&](const size_t& newJobsFinished)
+        {
+            const auto newJobCount{ jobsFinished += newJobsFinished };
+
+            if (!progressCallback)
+                return;
+
+            std::unique_lock<std::mutex> lock(progressMutex, std::try_to_lock);
+
+            if (!lock.owns_lock())
+                return;
+
+            const auto now{ std::chrono::steady_clock::now() };
+
+            if (now - lastReportTime >= settings.progressInterval)
+            {
+                lastReportTime = now;
+                progressCallback({ newJobCount, jobCount });
+            }
+        }
+    };
+
+    auto tuneNote{ [&, this](const int rootNote, int note)
+        {
+            if (isCancelled(settings))
+                return;
+
+            std::optional<TuningCounters::Scope> countingScope;
+
+            if (statistics != nullptr)
+                countingScope.emplace(statistics->jobs[rootNote * size() + note]);
+
+            if (rootNote == note)
+                tunings[rootNote][note] = 1;
+            else if (settings.engine == TuningEngine::monteCarlo)
+            {
+                Real logVariance;
+                tunings[rootNote][note] = sampleTuning(rootNote, note, settings, logVariance);
+
+                if (logVariances != nullptr)
+                    (*logVariances)[rootNote][note] = logVariance;
+            }
+            else
+                tunings[rootNote][note] = makeTuning(rootNote, note, settings);
+
+            if (jobFinished && !isCancelled(settings))
+                jobFinished(rootNote, note, tunings[rootNote]);
+
+            reportProgress(1);
+        }
+    };
+
+    auto tuneRootNote{ [&, this](const int rootNote)
+        {
+            if (isCancelled(settings))
+                return;
+
+            std::optional<TuningCounters::Scope> countingScope;
+
+            if (statistics != nullptr)
+                countingScope.emplace(statistics->jobs[rootNote]);
+
+            makeExactTuningsForRootNote(rootNote, tunings[rootNote], settings.cancellationToken);
+
+            if (jobFinished && !isCancelled(settings))
+                jobFinished(rootNote, -1, tunings[rootNote]);
+
+            reportProgress(size());
+        }
+    };
+
+    if constexpr (!tuningStatisticsEnabled)
+        statistics = nullptr;
+
+    if (statistics != nullptr)
+    {
+        statistics->jobs.clear();
+
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+            if (useExactSubsets)
+                statistics->jobs.push_back({ rootNote, -1 });
+            else
+                for (auto note{ 0 }; note != size(); ++note)
+                    statistics->jobs.push_back({ rootNote, note });
+    }
+
+    if (settings.threadPool == nullptr)
+    {
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+            if (useExactSubsets)
+            {
+                if (!isJobToTune || isJobToTune(rootNote, -1))
+                    tuneRootNote(rootNote);
+            }
+            else
+                for (auto note{ 0 }; note != size(); ++note)
+                    if (!isJobToTune || isJobToTune(rootNote, note))
+                        tuneNote(rootNote, note);
+    }
+    else
+    {
+        TaskGroup tasks(*settings.threadPool);
+
+        for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+            if (useExactSubsets)
+            {
+                if (!isJobToTune || isJobToTune(rootNote, -1))
+                    tasks.run([&tuneRootNote, rootNote]() { tuneRootNote(rootNote); });
+            }
+            else
+                for (auto note{ 0 }; note != size(); ++note)
+                    if (!isJobToTune || isJobToTune(rootNote, note))
+                        tasks.run([&tuneNote, rootNote, note]() { tuneNote(rootNote, note); });
+
+        tasks.wait();
+    }
+
+    if (progressCallback && !isCancelled(settings))
+        progressCallback({ jobsFinished, jobCount });
+
+    if (writeToConsole)
+        std::cout << "\n" << std::endl;
 
     return tunings;
 }
 
-std::vector<double> Scale::normaliseTuningsAndMakeAverageTuning(std::vector<std::vector<long double>>& tunings, const int& trueRootNote) const
+template<typename Real>
+std::vector<std::vector<Real>> BasicScale<Real>::makeCheckpointedTunings(const TuningSettings& settings,
+                                                                         TuningStatistics* statistics,
+                                                                         PartialTunings checkpoint) const
+{
+    auto isJobToTune{ [&, this](const int& rootNote, const int& note)
+        {
+            const auto rootNoteIsTuned{ checkpoint.isTuned.begin() + rootNote * size() };
+
+            //a whole root note is tuned again unless every one of its notes was checkpointed
+            if (note == -1)
+                return std::find(rootNoteIsTuned, rootNoteIsTuned + size(), 0) != rootNoteIsTuned + size();
+
+            return rootNoteIsTuned[note] == 0;
+        }
+    };
+
+    //checkpoints are written while holding the mutex, so that an older one never replaces a newer one
+    std::mutex checkpointMutex;
+    auto lastCheckpointTime{ std::chrono::steady_clock::now() };
+
+    auto recordJob{ [&, this](const int& rootNote, const int& note, const std::vector<Real>& rootNoteTunings)
+        {
+            std::lock_guard<std::mutex> lock(checkpointMutex);
+
+            recordTunedJob(checkpoint, rootNote, note, rootNoteTunings);
+
+            const auto now{ std::chrono::steady_clock::now() };
+
+            if (now - lastCheckpointTime >= settings.checkpointInterval)
+            {
+                lastCheckpointTime = now;
+                checkpoint.writeFile(settings.checkpointPath);
+            }
+        }
+    };
+
+    auto tunings{ makePopulatedTunings(settings, nullptr, statistics, isJobToTune, recordJob) };
+
+    //every job has finished, so nothing else reads or writes checkpoint
+    checkpoint.writeFile(settings.checkpointPath);
+
+    if (isCancelled(settings))
+        return tunings;
+
+    for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
+        for (auto note{ 0 }; note != size(); ++note)
+            tunings[rootNote][note] = (Real)checkpoint.tunings[rootNote * size() + note];
+
+    return tunings;
+}
+
+template<typename Real>
+void BasicScale<Real>::recordTunedJob(PartialTunings& partialTunings, const int& rootNote, const int& note,
+                                      const std::vector<Real>& rootNoteTunings) const
+{
+    const auto firstNote{ note == -1 ? 0 : note };
+    const auto lastNote{ note == -1 ? size() - 1 : note };
+
+    for (auto tunedNote{ firstNote }; tunedNote <= lastNote; ++tunedNote)
+    {
+        partialTunings.tunings[rootNote * size() + tunedNote] = rootNoteTunings[tunedNote];
+        partialTunings.isTuned[rootNote * size() + tunedNote] = 1;
+    }
+}
+
+template<typename Real>
+bool BasicScale<Real>::usesExactSubsets(const TuningSettings& settings) const
+{
+    return settings.engine == TuningEngine::exactSubsets &&
+           (settings.weightCutoff == 0 || settings.maxCentsError > 0) && size() > 1 &&
+           size() <= maxExactSubsetNotes;
+}
+
+template<typename Real>
+std::vector<double> BasicScale<Real>::normaliseTuningsAndMakeAverageTuning(std::vector<std::vector<Real>>& tunings,
+                                                                           const int& trueRootNote) const
 {
     //normalise
     for (auto rootNote{ 1 }; rootNote != size(); ++rootNote)
         if (rootNote != trueRootNote)
         {
-            const auto adjustmentFactor{ 1L / tunings[rootNote][trueRootNote] };
+            const auto adjustmentFactor{ Real(1) / tunings[rootNote][trueRootNote] };
 
             for (auto& tunedNote : tunings[rootNote])
                 tunedNote *= adjustmentFactor;
@@ -266,12 +1505,13 @@ std::vector<double> Scale::normaliseTuningsAndMakeAverageTuning(std::vector<std:
 
     for (auto note{ 0 }; note != size(); ++note)
         for (auto rootNote{ 0 }; rootNote != size(); ++rootNote)
-            averageTuning[note] *= std::pow(tunings[rootNote][note], 1L / (long double)size());
+            averageTuning[note] *= std::pow(tunings[rootNote][note], Real(1) / (Real)size());
 
     return averageTuning;
 }
 
-std::vector<double> Scale::insertDummyNotes(std::vector<double>& tuning) const
+template<typename Real>
+std::vector<double> BasicScale<Real>::insertDummyNotes(std::vector<double>& tuning) const
 {
     tuning.reserve(tuning.size() + dummyIndecies.size());
 
@@ -288,11 +1528,41 @@ std::vector<double> Scale::insertDummyNotes(std::vector<double>& tuning) const
     return tuning;
 }
 
-void Scale::normaliseWeights()
+template<typename Real>
+void BasicScale<Real>::cacheIntervalMatrix()
+{
+    intervalMatrix.noteCount = size();
+    intervalMatrix.sizes.assign(size() * size(), 1);
+    intervalMatrix.logSizes.assign(size() * size(), 0);
+    intervalMatrix.weights.assign(size() * size(), 0);
+
+    for (auto noteTo{ 0 }; noteTo != size(); ++noteTo)
+        for (auto noteFrom{ 0 }; noteFrom != size(); ++noteFrom)
+            if (noteTo != noteFrom)
+            {
+                const auto interval{ getInterval(noteTo, noteFrom) };
+                const auto index{ noteTo * size() + noteFrom };
+
+                intervalMatrix.sizes[index] = interval.getSize();
+                intervalMatrix.logSizes[index] = std::log2(interval.getSize());
+                intervalMatrix.weights[index] = interval.getWeight();
+            }
+}
+
+template<typename Real>
+void BasicScale<Real>::normaliseWeights()
 {
-    long double maxWeight{ getMaxWeight() };
+    Real maxWeight{ getMaxWeight() };
 
     for (auto& row : intervalsPattern)
         for (auto& Interval : row)
             Interval.setWeight(Interval.getWeight() / maxWeight);
-}
\ No newline at end of file
+}
+
+template class BasicInterval<float>;
+template class BasicInterval<double>;
+template class BasicInterval<long double>;
+
+template class BasicScale<float>;
+template class BasicScale<double>;
+template class BasicScale<long double>;
\ No newline at end of file
@@ -1,70 +1,317 @@
 #pragma once
 #include "Fraction.h"
+#include "Monzo.h"
 #include "Utilities.h"
+#include "NoteSet.h"
+#include "PartialTunings.h"
+#include "PathSampler.h"
+#include "ScaleTraversal.h"
+#include "ThreadPool.h"
+#include "TuningCache.h"
+#include "TuningStatistics.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <limits>
+#include <optional>
 
 /*
   Musically, an interval between two notes is the factor you need to multiply one note by to a arrive
   at the other. Mathematically, this number is the interval's size, while it's weight represents how
   "important" it is (howver that is interpreted).
+  Real is the numeric type used to store the interval.
 */
-class Interval
+template<typename Real>
+class BasicInterval
 {
 public:
     /*
       Constructs an interval of size and weight = 1;
     */
-    Interval();
+    BasicInterval();
 
     /*
       Constructs an interval of size s and weight w. These values are clamped to limits if they exceed
       numeric limits.
     */
-    Interval(const long double& s, const long double& w = 1);
+    BasicInterval(const Real& s, const Real& w = 1);
 
     /*
       Returns the size of the interval.
     */
-    inline long double getSize() const;
+    inline Real getSize() const
+    {
+        return size;
+    }
 
     /*
       Returns the weight of the interval.
     */
-    inline long double getWeight() const;
+    inline Real getWeight() const
+    {
+        return weight;
+    }
 
     /*
       Sets the size of the interval and clamps it's value to numeric limits if necassary.
     */
-    void setSize(const long double& newSize);
+    void setSize(const Real& newSize);
     
     /*
       Sets the size of the interval, clamps it's value to numeric limits, and manages weight = 0 if necassary.
     */
-    void setWeight(const long double& newWeight);
+    void setWeight(const Real& newWeight);
 
     /*
       Sets both the size and weight of the interval.
     */
-    void setInterval(const long double& newSize, const long double& newWeight);
+    void setInterval(const Real& newSize, const Real& newWeight);
 
 private:
     /*
       The distance between two notes.
     */
-    long double size;
+    Real size;
     /*
       The "importance" of the interval.
     */
-    long double weight;
+    Real weight;
 
     /*
       Weights <= 0, which are impossible accordin to the model of tuning used as they can lead to division by
-      0, are set to the numeric limits lowest value for long double.
+      0, are set to the numeric limits lowest value for Real.
     */
     void manageZeroWeight();
 };
 
-using IntervalsPattern = std::vector<std::vector<Interval>>;
+/*
+  Intervals are given to a Scale, and produced by IntervalPatternMakers, in long double. The Scale converts
+  them to the numeric type it calculates with.
+*/
+using Interval = BasicInterval<long double>;
+
+template<typename Real>
+using BasicIntervalsPattern = std::vector<std::vector<BasicInterval<Real>>>;
+
+using IntervalsPattern = BasicIntervalsPattern<long double>;
+
+/*
+  The algorithms Scale::tuneScale() can use to traverse a scale.
+*/
+enum class TuningEngine
+{
+    /*
+      Multiplies the sizes of intervals along each path, raising each to the power of its weight.
+    */
+    product,
+    /*
+      Sums the weighted log sizes of intervals along each path, so only one exponential is calculated for
+      each (rootNote, note) pair. This is faster and cannot overflow on long paths.
+    */
+    logarithmic,
+    /*
+      Calculates the exact tuning for weightCutoff == 0 by memoising the result of every traversal on
+      (lastNote, set of notes not yet in the path), taking O(2^n * n^2) time per root note rather than
+      O(n!). Falls back to logarithmic if weightCutoff > 0 or the scale has more than maxExactSubsetNotes
+      notes, as the memo table of a root note takes (n - 1) * 2^(n - 2) Reals: 80 MB for 20 notes of long
+      doubles and 1.5 GB for 24. Each thread tuning a root note holds its own table, so root notes are only
+      tuned at the same time, across every scale in the process, while their tables fit in
+      exactSubsetsMemoryBudget.
+    */
+    exactSubsets,
+    /*
+      Estimates the tuning from random paths drawn by PathSampler, sampleBudget in total, rather than from
+      every path. Use Scale::estimateTuning() to also get the standard error of each note.
+    */
+    monteCarlo
+};
+
+/*
+  The largest scale TuningEngine::exactSubsets will tune.
+*/
+static constexpr size_t maxExactSubsetNotes{ 24 };
+
+/*
+  The most memory the memo tables of TuningEngine::exactSubsets may take at once, over every thread of the
+  process. A root note whose table doesn't fit waits for others to finish, unless no other table is held,
+  so a single table larger than the budget is still made.
+*/
+static constexpr size_t exactSubsetsMemoryBudget{ size_t(2) << 30 };
+
+/*
+  Lets one thread stop a Scale::tuneScale() running on another. Every traversal checks the token, so a
+  cancelled tuning stops within a few thousand steps of its slowest traversal.
+*/
+class CancellationToken
+{
+public:
+    /*
+      Asks every tuning watching this token to stop.
+    */
+    inline void cancel()
+    {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /*
+      Returns true once cancel() has been called.
+    */
+    inline bool isCancelled() const
+    {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> cancelled{ false };
+};
+
+/*
+  How far Scale::tuneScale() has got, counted in (rootNote, note) pairs.
+*/
+struct TuningProgress
+{
+    size_t jobsFinished;
+    size_t jobCount;
+};
+
+/*
+  Settings which control how Scale::tuneScale() calculates a tuning.
+*/
+struct TuningSettings
+{
+    /*
+      Paths whose rolling weight falls to or below this value are treated as if they had reached the root
+      note. Smaller values produce more accurate tunings but take longer to compute.
+    */
+    long double weightCutoff{ 0 };
+    /*
+      If greater than 0, weightCutoff is ignored, and the tuning of every note is instead guaranteed to be
+      within this many cents of the tuning with a weightCutoff of 0. Subtrees of paths are pruned only where
+      the most they could move the tuning fits in what remains of the error allowed. As that bound is for the
+      worst case, tunings are typically hundreds of times closer than this, and take about as long as with
+      the weightCutoff which happens to reach the same error. Every engine but TuningEngine::monteCarlo
+      traverses as TuningEngine::logarithmic does while this is set, except that TuningEngine::exactSubsets
+      calculates the exact tuning where it can. tuneScaleUntil(), estimateRuntime() and
+      chooseWeightCutoff() ignore it.
+    */
+    double maxCentsError{ 0 };
+    /*
+      If not nullptr, the tuning of every (rootNote, note) pair is calculated as a separate task on this
+      pool. Otherwise the tuning is calculated on the calling thread.
+    */
+    ThreadPool* threadPool{ nullptr };
+    /*
+      The algorithm used to traverse the scale.
+    */
+    TuningEngine engine{ TuningEngine::product };
+    /*
+      How closely the log2 and exp2 approximations used while traversing the scale follow std::log2 and
+      std::exp2. Anything but exact trades accuracy for speed.
+    */
+    ApproximationAccuracy approximationAccuracy{ ApproximationAccuracy::exact };
+    /*
+      If not 0, and threadPool is not nullptr, the traversal of each (rootNote, note) pair by
+      TuningEngine::logarithmic is split below this many levels of its tree of paths, and every subtree is
+      run as a separate task on threadPool, so that a single expensive pair can use every thread. Deeper
+      splits make more, smaller tasks.
+    */
+    size_t subtreeSplitDepth{ 0 };
+    /*
+      If set, called with the progress of the tuning at most once every progressInterval, and once when it
+      finishes. It may be called from any thread tuning the scale, but never from two at once. If not set,
+      progress is written to std::cout unless silent is true.
+    */
+    std::function<void(const TuningProgress&)> progressCallback;
+    std::chrono::milliseconds progressInterval{ 100 };
+    /*
+      If true and progressCallback is not set, tuneScale() writes nothing.
+    */
+    bool silent{ false };
+    /*
+      If not nullptr and cancelled, tuneScale() stops as soon as it can and returns an empty tuning.
+    */
+    const CancellationToken* cancellationToken{ nullptr };
+    /*
+      The number of paths TuningEngine::monteCarlo samples, shared equally between every (rootNote, note)
+      pair, and the seed they are sampled with. The same seed gives the same tuning however many threads
+      are used.
+    */
+    size_t sampleBudget{ 1000000 };
+    uint64_t samplingSeed{ 0 };
+    /*
+      If not nullptr, tuneScale() answers from this cache when it holds the populated tunings of the scale
+      for these settings, and otherwise stores them in it once they are calculated.
+    */
+    TuningCache* cache{ nullptr };
+    /*
+      If not empty, tuneScale() writes every (rootNote, note) pair it has tuned so far to this file, at most
+      once every checkpointInterval and once more when it finishes or is cancelled, so that
+      Scale::resumeTuneScale() can carry on from where an interrupted tuning stopped. Each checkpoint replaces
+      the last atomically, so the file always holds a whole checkpoint, and the tuning carries on if it can't
+      be written. Nothing is written if the tuning is answered from cache.
+    */
+    std::filesystem::path checkpointPath;
+    std::chrono::seconds checkpointInterval{ 60 };
+};
+
+/*
+  A tuning produced by Scale::estimateTuning(), with the standard error of the tuning of each note in cents.
+  Both are NaN at dummy notes.
+*/
+struct TuningEstimate
+{
+    std::vector<double> tuning;
+    std::vector<double> standardErrorsInCents;
+};
+
+/*
+  A tuning produced by Scale::tuneScaleUntil(), with the fraction of the weight of the paths of each note
+  which had been traversed by the last pass to finish each pair by its deadline, the mean over every root
+  note. Both are NaN at dummy notes.
+*/
+struct AnytimeTuning
+{
+    std::vector<double> tuning;
+    std::vector<double> coverage;
+    /*
+      True if every path was traversed before the deadline, in which case tuning is the tuning
+      TuningEngine::logarithmic produces.
+    */
+    bool complete;
+};
+
+/*
+  The result of timing two tuning engines against each other with Scale::compareEngines().
+*/
+struct EngineComparison
+{
+    double baselineSeconds;
+    double candidateSeconds;
+    /*
+      baselineSeconds / candidateSeconds.
+    */
+    double speedup;
+    /*
+      The greatest difference between the tunings produced by each engine for any note, in cents.
+    */
+    double maxCentsDifference;
+};
+
+/*
+  A prediction by Scale::estimateRuntime() of the work Scale::tuneScale() would do with some settings.
+*/
+struct RuntimeEstimate
+{
+    long double weightCutoff;
+    /*
+      The number of nodes every traversal of the scale would enter, counted as TuningStatistics counts
+      them, and the standard error of that estimate. For TuningEngine::monteCarlo, the number of paths
+      sampled, which is known exactly.
+    */
+    double nodeCount;
+    double nodeCountStandardError;
+    double seconds;
+};
 
 /*
   A Scale represents a collection of notes as the ideal pattern intervals between those notes.
@@ -73,42 +320,50 @@ using IntervalsPattern = std::vector<std::vector<Interval>>;
   is calculated, but it involves treating scales as complete weighted graphs. It may also
   contain some 'dummy' notes, which are not contained in the scale but are contained in the
   pitch space containing it (think black notes in the C major scale).
+
+  Real is the numeric type every calculation of the tuning is made in. long double is the most precise,
+  but on many platforms double and float are several times faster, so Scale is BasicScale<long double>
+  and the faster variants can be used where their precision is enough.
 */
-class Scale
+template<typename Real>
+class BasicScale
 {
 public:
     /*
       Constructs a nameless scale with a default intervals pattern.
     */
-    Scale();
+    BasicScale();
 
     /*
       Constructs a named scale with a default intervals pattern.
     */
-    Scale(const std::string& n);
+    BasicScale(const std::string& n);
 
     /*
       Constructs a nameless scale with intervals pattern i. If i has non-triangular dimensions
-      (defined by patternHasTriangularDimensions() function in Utilities.h) then the pattern is
-      default
+      (defined by patternHasTriangularDimensions() function in Utilities.h) or more than maxMidiNotes
+      notes then the pattern is default.
     */
-    Scale(const IntervalsPattern& i);
+    BasicScale(const IntervalsPattern& i);
 
     /*
        Constructs a named scale with intervals pattern i. If i has non-triangular dimensions
-       (defined by patternHasTriangularDimensions() function in Utilities.h) then the pattern is
-       default.
+       (defined by patternHasTriangularDimensions() function in Utilities.h) or more than maxMidiNotes
+       notes then the pattern is default.
     */
-    Scale(const IntervalsPattern& i, const std::string& n);
+    BasicScale(const IntervalsPattern& i, const std::string& n);
 
     /*
       Returns the number of notes in the scale.
     */
-    inline size_t size() const;
+    inline size_t size() const
+    {
+        return intervalsPattern.size() + 1;
+    }
 
     /*
       Sets intervalsPattern to newIntervalsPattern if it has triangular dimensions, (defined by
-      patternHasTriangularDimensions() function in Utilities.h).
+      patternHasTriangularDimensions() function in Utilities.h) and at most maxMidiNotes notes.
     */
     void setIntervalsPattern(const IntervalsPattern& newIntervalsPattern);
 
@@ -128,17 +383,20 @@ public:
     /*
       Returns the name of the scale if it has one.
     */
-    inline std::string getName() const;
+    inline std::string getName() const
+    {
+        return name;
+    }
 
     /*
       Returns the smallest weight of all intervals in the scale. 
     */
-    long double getMinWeight() const;
+    Real getMinWeight() const;
 
     /*
       Returns the greatest weight of all intervals in the scale.
     */
-    long double getMaxWeight() const;
+    Real getMaxWeight() const;
 
     /*
       Produces a tuning of the scale. The tuning of the note at index = trueRootNote will always equal 1f
@@ -147,13 +405,116 @@ public:
     */
     std::vector<double> tuneScale(const int& trueRootNote, const long double& weightCutoff = 0) const;
 
+    /*
+      Produces a tuning of the scale as above, calculated according to settings. The tuning is the same
+      whether or not settings contains a thread pool. Returns an empty tuning if the tuning is cancelled
+      through settings.cancellationToken.
+    */
+    std::vector<double> tuneScale(const int& trueRootNote, const TuningSettings& settings) const;
+
+    /*
+      Produces a tuning of the scale as above, and writes what its traversals did to statistics. Nothing is
+      counted, and statistics.collected is false, unless TUNING_STATISTICS is defined as 1.
+    */
+    std::vector<double> tuneScale(const int& trueRootNote, const TuningSettings& settings,
+                                  TuningStatistics& statistics) const;
+
+    /*
+      Produces a tuning of the scale as tuneScale() does, tuning only the pairs not already in the checkpoint
+      at settings.checkpointPath, and carrying on checkpointing to it. If there is no checkpoint file the
+      scale is tuned from the start, as tuneScale() would tune it. Returns an empty tuning if the checkpoint
+      can't be read or was made for a different scale or settings, such as another weightCutoff, which
+      leaves it unchanged, or if the tuning is cancelled.
+    */
+    std::vector<double> resumeTuneScale(const int& trueRootNote, const TuningSettings& settings) const;
+
+    /*
+      Produces a tuning of the scale as tuneScale() does, along with the standard error of each note's
+      tuning, which is 0 for every engine but TuningEngine::monteCarlo. Returns an empty estimate if the
+      tuning is cancelled.
+    */
+    TuningEstimate estimateTuning(const int& trueRootNote, const TuningSettings& settings) const;
+
+    /*
+      Produces the best tuning of the scale it can by deadline, for previews which must be ready in time.
+      The paths of every (rootNote, note) pair are traversed as TuningEngine::logarithmic traverses them,
+      in passes with falling weight cutoffs: cheap passes first, which measure how the time a pass takes
+      grows as its cutoff falls, and then one with the cutoff predicted to take most of the time left.
+      Each pair's tuning is the one TuningEngine::logarithmic would produce with the cutoff of the last
+      pass to finish that pair by deadline, or before settings.cancellationToken is cancelled. A later
+      deadline usually leaves smaller cutoffs, but as passes are planned from the time they take, and the
+      error of a tuning doesn't always fall with the cutoff, it isn't certain to give a closer tuning.
+      Traversal stops once every path has been traversed, or those settings.weightCutoff lets in.
+      settings.engine is ignored, and the pairs of each pass are traversed on settings.threadPool if it
+      is not nullptr.
+    */
+    AnytimeTuning tuneScaleUntil(const int& trueRootNote, const TuningSettings& settings,
+                                 const std::chrono::steady_clock::time_point& deadline) const;
+
+    /*
+      Tunes only shard shardIndex of shardCount of the (rootNote, note) pairs of the scale, so that the
+      tuning of a scale can be shared between processes, each tuning one shard according to the same
+      settings. Pairs are dealt to the shards in turn, or whole root notes when TuningEngine::exactSubsets
+      tunes every note of a root note at once, so that each shard has a similar share of the work. The
+      tunings are keyed by the scale and settings, and combined with those of every other shard by
+      mergeShards(). Nothing is tuned if shardIndex is not less than shardCount, and pairs not yet tuned
+      when the tuning is cancelled are left untuned.
+    */
+    PartialTunings tuneShard(const size_t& shardIndex, const size_t& shardCount, const TuningSettings& settings) const;
+
+    /*
+      Produces the tuning of the scale tuneScale() would produce from shards, the partial tunings made by
+      tuneShard(), or any others, with the same settings. Returns an empty tuning if any of shards was made
+      for a different scale or settings, or if some pair was tuned by none of them. If settings.cache
+      is not nullptr, the merged tunings are stored in it, as tuneScale() would store them.
+    */
+    std::vector<double> mergeShards(const std::vector<PartialTunings>& shards, const int& trueRootNote,
+                                    const TuningSettings& settings) const;
+
+    /*
+      Tunes the scale once with baselineEngine and once with candidateEngine, otherwise according to
+      settings, and reports how much faster candidateEngine was and how far apart the two tunings are.
+      Neither tuning writes to settings.checkpointPath.
+    */
+    EngineComparison compareEngines(const int& trueRootNote, const TuningSettings& settings,
+                                    const TuningEngine& baselineEngine, const TuningEngine& candidateEngine) const;
+
+    /*
+      Predicts how long tuneScale() would take with settings, without tuning the scale. The tree of paths of
+      every (rootNote, note) pair is sized from probesPerPair random paths through it, seeded by
+      settings.samplingSeed, and the time each node takes is measured by tuning the scale with a cutoff
+      large enough that it takes a few milliseconds, on settings.threadPool, so the prediction is for the
+      threads the tuning would have. That tuning neither uses settings.cache nor writes to
+      settings.checkpointPath.
+    */
+    RuntimeEstimate estimateRuntime(const TuningSettings& settings, const size_t& probesPerPair = 256) const;
+
+    /*
+      Returns the smallest weight cutoff with which tuneScale() is predicted by estimateRuntime() to finish
+      within budget, otherwise using settings, or std::nullopt if even a cutoff of 1 is predicted to take
+      longer. The cutoff is found to within a few percent. settings.maxCentsError is ignored, as tuneScale()
+      ignores the cutoff while it is set, so it must be 0 in the settings the cutoff is used with.
+    */
+    std::optional<long double> chooseWeightCutoff(const std::chrono::duration<double>& budget,
+                                                  const TuningSettings& settings,
+                                                  const size_t& probesPerPair = 256) const;
+
+    /*
+      Returns a traversal which tunes note against rootNote as TuningEngine::logarithmic does, to be run
+      step by step by the caller. The traversal reads this scale's intervals, so the scale must outlive it
+      and must not be modified while it runs. If maxCentsError is greater than 0, the traversal is pruned as
+      TuningSettings::maxCentsError describes instead of by weightCutoff.
+    */
+    ScaleTraversal<Real> makeTraversal(const int& rootNote, const int& note, const long double& weightCutoff,
+                                       const double& maxCentsError = 0) const;
+
 private:
     /*
       The ideal intervals between all notes in the scale. The interval between notes A and B is equal to
       the reciporical of the interval between B and A. The weight of both intervals is the same. So,
       we only need to store the interval between A and B for any value of A or B.
     */
-    IntervalsPattern intervalsPattern;
+    BasicIntervalsPattern<Real> intervalsPattern;
     /*
       The indecies of intervals which will always be tuned NaN in tuneScale().
     */
@@ -162,44 +523,150 @@ private:
       The name of the scale;
     */
     std::string name;
+    /*
+      intervalsPattern expanded into the form read while tuning the scale. Calculated whenever the
+      intervals pattern is set.
+    */
+    IntervalMatrix<Real> intervalMatrix;
+
+    /*
+      Returns true if pattern can be the intervals pattern of a scale: it is triangular and describes at
+      most maxMidiNotes notes.
+    */
+    static bool isValidIntervalsPattern(const IntervalsPattern& pattern);
+
+    /*
+      Returns pattern converted to Real if it is valid (see isValidIntervalsPattern()), otherwise returns an
+      empty pattern.
+    */
+    static BasicIntervalsPattern<Real> convertIntervalsPattern(const IntervalsPattern& pattern);
 
     /*
       Accesses or calculates the value of the interval from noteFrom to noteTo depending on whether or not
       it is contained in intervalsPattern.
     */
-    Interval getInterval(const int& noteTo, const int& noteFrom) const;
+    BasicInterval<Real> getInterval(const int& noteTo, const int& noteFrom) const;
+
+    /*
+      Returns a key which identifies the populated tunings calculated with settings: the precision of Real,
+      the settings which change the tunings, the normalised intervals pattern, and the dummy indecies. Each
+      number is written independently of how it is laid out in memory.
+    */
+    std::string makeCacheKey(const TuningSettings& settings) const;
 
     /*
       Returns the sum of all notes in notesFrom to noteTo. This is a useful value for tuning calculation.
     */
-    long double sumWeights(const int& noteTo, std::vector<int>& notesFrom) const;
+    Real sumWeights(const int& noteTo, const NoteSet& notesFrom) const;
+
+    /*
+      Removes note from remainingWeightSums, a running total for every note in the scale of the weights of
+      the intervals from the notes remaining in a path to that note. This is O(1) per total, so the sum of
+      the weights to any note is read from remainingWeightSums rather than recalculated by sumWeights().
+    */
+    void removeFromRemainingWeightSums(const int& note, std::vector<Real>& remainingWeightSums) const;
+
+    /*
+      Restores note to remainingWeightSums after removeFromRemainingWeightSums().
+    */
+    void restoreToRemainingWeightSums(const int& note, std::vector<Real>& remainingWeightSums) const;
+
+    /*
+      Produces a tuning of the scale as tuneScale() does, counting into statistics if it is not nullptr, and
+      resuming from checkpoint if it is not nullptr and settings.checkpointPath is not empty.
+    */
+    std::vector<double> tuneScaleWithStatistics(const int& trueRootNote, const TuningSettings& settings,
+                                                TuningStatistics* statistics,
+                                                const PartialTunings* checkpoint = nullptr) const;
+
+    /*
+      Calculates the populated tunings as makePopulatedTunings() does, tuning only the pairs not in
+      checkpoint and adding each to it once tuned, and writes checkpoint to settings.checkpointPath as
+      TuningSettings::checkpointPath describes.
+    */
+    std::vector<std::vector<Real>> makeCheckpointedTunings(const TuningSettings& settings, TuningStatistics* statistics,
+                                                           PartialTunings checkpoint) const;
+
+    /*
+      Marks the pairs of a job of makePopulatedTunings() as tuned in partialTunings, with their tunings from
+      rootNoteTunings, the tunings of the job's root note.
+    */
+    void recordTunedJob(PartialTunings& partialTunings, const int& rootNote, const int& note,
+                        const std::vector<Real>& rootNoteTunings) const;
+
+    /*
+      Estimates the number of nodes tuneScale() would enter with settings, as estimateRuntime() does, and
+      writes the variance of the estimate to variance.
+    */
+    double estimateNodeCount(const TuningSettings& settings, const size_t& probesPerPair, double& variance) const;
+
+    /*
+      Measures the time tuneScale() takes per node with settings, or per path for TuningEngine::monteCarlo,
+      by timing a tuning with a larger cutoff, or a smaller sample budget, than settings have.
+    */
+    double measureSecondsPerNode(const TuningSettings& settings, const size_t& probesPerPair) const;
 
     /*
       Calculates the tuning of a single note for a scale, assuming a single rootNote.
     */
-    long double makeTuning(const int& rootNote, int& note, const long double& weightCutoff) const;
+    Real makeTuning(const int& rootNote, int& note, const TuningSettings& settings) const;
+
+    /*
+      Estimates the tuning of a single note for a single rootNote as TuningEngine::monteCarlo, and writes the
+      variance of the base 2 logarithm of the estimate to logVariance.
+    */
+    Real sampleTuning(const int& rootNote, const int& note, const TuningSettings& settings, Real& logVariance) const;
 
     /*
       Iteratively traverses across the scale as if it were a graph. Iteration is broken by either finding a
       path which originates at rootNote, or arriving at a path whose rollingWeight <= weightCutoff. Being that
-      this function is called many times, it could be a sensible place to begin optimisation.
+      this function is called many times, it could be a sensible place to begin optimisation. The siblings
+      which end a path are found with SiblingKernels and contribute a single power between them.
     */
-    long double traverseScale(int& lastNote, std::vector<int>& possibleNextNotesInPath, const int& rootNote,
-                              const long double& rollingWeight, const long double& weightCutoff,
-                              const long double& possibleWeightsToNoteSum) const;
-    
+    Real traverseScale(int& lastNote, NoteSet& possibleNextNotesInPath, std::vector<Real>& remainingWeightSums,
+                       const int& rootNote, const Real& rollingWeight, const Real& weightCutoff,
+                       const Real& possibleWeightsToNoteSum, const TuningSettings& settings) const;
+
+    /*
+      Calculates the tuning of every note in the scale for a single rootNote with weightCutoff == 0, as
+      TuningEngine::exactSubsets, and writes them to rootNoteTunings. Stops early, leaving rootNoteTunings
+      incomplete, if cancellationToken is cancelled.
+    */
+    void makeExactTuningsForRootNote(const int& rootNote, std::vector<Real>& rootNoteTunings,
+                                     const CancellationToken* cancellationToken) const;
+
     /*
       Manages calls to makeTuning() for all possible notes and rootNotes, populates size() number of tunings
-      for each note in the scale, and tracks progress of this calculation.
+      for each note in the scale, and reports progress of this calculation. If settings contains a thread
+      pool, each call to makeTuning() is a task on that pool which writes only to its own element of the
+      returned tunings. If logVariances is not nullptr, the variance of the base 2 logarithm of each tuning
+      is written to it. If statistics is not nullptr and TUNING_STATISTICS is defined as 1, what each call
+      to makeTuning() did is appended to statistics->jobs.
+
+      A job is a (rootNote, note) pair, or a whole root note, with a note of -1, when TuningEngine::exactSubsets
+      tunes every note of a root note at once. If isJobToTune is set, only the jobs for which it returns true
+      are tuned, and the tunings of the rest are left 0. If jobFinished is set, it is called with each job
+      and the tunings of its root note once the job is tuned and not cancelled, from the thread which tuned it.
     */
-    std::vector<std::vector<long double>> makePopulatedTunings(const long double& weightCutoff) const;
+    std::vector<std::vector<Real>> makePopulatedTunings(const TuningSettings& settings,
+                                                        std::vector<std::vector<Real>>* logVariances = nullptr,
+                                                        TuningStatistics* statistics = nullptr,
+                                                        const std::function<bool(const int&, const int&)>& isJobToTune = {},
+                                                        const std::function<void(const int&, const int&,
+                                                                                 const std::vector<Real>&)>& jobFinished = {}) const;
+
+    /*
+      Returns true if makePopulatedTunings() tunes every note of a root note at once, with
+      makeExactTuningsForRootNote(), when tuning with settings.
+    */
+    bool usesExactSubsets(const TuningSettings& settings) const;
 
     /*
       Produces a tuning of the scale from the tunings produced by makePopulatedTunings(), normalised and averaged
       such that the tuning of the note at index trueRootNote equals 1f
     */
-    std::vector<double> normaliseTuningsAndMakeAverageTuning(std::vector<std::vector<long double>>& tunings,
-                                                                  const int& trueRootNote) const;
+    std::vector<double> normaliseTuningsAndMakeAverageTuning(std::vector<std::vector<Real>>& tunings,
+                                                             const int& trueRootNote) const;
 
     /*
       Inserts NaN at the indecies contained in dummyIndecies if those intervals are valid.
@@ -210,8 +677,15 @@ private:
       Normalises the weights of all intervals in intervalsPattern to a range of (0, 1].
     */
     void normaliseWeights();
+
+    /*
+      Calculates intervalMatrix from intervalsPattern.
+    */
+    void cacheIntervalMatrix();
 };
 
+using Scale = BasicScale<long double>;
+
 
 //All functions in this namespace should return an IntervalPattern which can be used by Scale objects.
 namespace IntervalPatternMakers
@@ -248,6 +722,31 @@ namespace IntervalPatternMakers
         return pattern;
     }
 
+    /*
+      Produces an IntervalsPattern as rangedScaleFractionsToIntervalsWithTenneyWeight() does from the
+      monzos of the same ratios.
+    */
+    static IntervalsPattern
+        rangedScaleMonzosToIntervalsWithTenneyWeight(const std::vector<std::vector<Monzo>>& rangedScale,
+            const long double& entropyCurve = 0)
+    {
+        IntervalsPattern pattern;
+        pattern.reserve(rangedScale.size());
+
+        for (auto rowItr{ rangedScale.begin() }; rowItr != rangedScale.end(); ++rowItr)
+        {
+            std::vector<Interval> intervalsRow;
+
+            intervalsRow.reserve(rowItr->size());
+            for (auto monzoItr{ rowItr->begin() }; monzoItr != rowItr->end(); ++monzoItr)
+                intervalsRow.push_back({ monzoItr->toLongDouble(), tenneyHeightOfMonzo(*monzoItr, entropyCurve) });
+
+            pattern.push_back(intervalsRow);
+        }
+
+        return pattern;
+    }
+
     /*
       Produces an IntervalsPattern where all intervals have equal weight.
     */
@@ -0,0 +1,495 @@
+#include "ScaleTraversal.h"
+#include <random>
+
+/*
+  The weight by which a child of mass childMass takes a share of the error budget of its node. Shares
+  grow much more slowly than masses, so that light children are given more budget than the error of
+  ending them, and heavy children, whose subtrees change the tuning most, are traversed with what
+  remains. Shares in proportion to mass would end a child only where its error per unit of mass fits in
+  the error per unit of mass allowed, which holds for no subtree more than a step or two deep.
+*/
+template<typename Real>
+static inline Real errorBudgetShare(const Real& childMass)
+{
+    return std::sqrt(std::sqrt(childMass));
+}
+
+template<typename Real>
+ScaleTraversal<Real>::ScaleTraversal(const IntervalMatrix<Real>& matrix, const int& root, const int& note,
+                                     const Real& cutoff, const Real& maxLogError, const bool& countsCutMass)
+    : intervalMatrix(matrix)
+    , rootNote(root)
+    , weightCutoff(maxLogError > 0 ? 0 : cutoff)
+    , isErrorBounded(maxLogError > 0)
+    , possibleNextNotesInPath(NoteSet::firstNotes(matrix.noteCount))
+    , remainingWeightSums(matrix.noteCount, 0)
+{
+    possibleNextNotesInPath.erase(note);
+
+    const auto& noteCount{ intervalMatrix.noteCount };
+
+    for (auto otherNote{ 0 }; otherNote != noteCount; ++otherNote)
+        for (auto remainingNotes{ possibleNextNotesInPath }; !remainingNotes.empty();)
+            remainingWeightSums[otherNote] += intervalMatrix.weights[otherNote * noteCount + remainingNotes.popFirst()];
+
+    //a path visits every note at most once, so this never reallocates
+    frames.reserve(noteCount);
+
+    const auto firstRollingWeight{ 1 / remainingWeightSums[note] };
+
+    if (isErrorBounded)
+    {
+        errorBudgetFrames.reserve(noteCount);
+        enterNodeWithinErrorBudget(note, firstRollingWeight, firstRollingWeight, 1, maxLogError);
+    }
+    else
+    {
+        if (countsCutMass)
+        {
+            masses.reserve(noteCount);
+            masses.push_back(1);
+        }
+
+        enterNode(note, firstRollingWeight, firstRollingWeight);
+    }
+}
+
+template<typename Real>
+ScaleTraversal<Real>::ScaleTraversal(const ScaleTraversal& parent, const int& lastNote, const Real& rollingWeight,
+                                     const Real& possibleWeightsToNoteSum, const Real& mass, const Real& errorBudget)
+    : intervalMatrix(parent.intervalMatrix)
+    , rootNote(parent.rootNote)
+    , weightCutoff(parent.weightCutoff)
+    , isErrorBounded(parent.isErrorBounded)
+    , possibleNextNotesInPath(parent.possibleNextNotesInPath)
+    , remainingWeightSums(parent.remainingWeightSums)
+{
+    frames.reserve(intervalMatrix.noteCount);
+
+    if (isErrorBounded)
+    {
+        errorBudgetFrames.reserve(intervalMatrix.noteCount);
+        enterNodeWithinErrorBudget(lastNote, rollingWeight, possibleWeightsToNoteSum, mass, errorBudget);
+    }
+    else
+        enterNode(lastNote, rollingWeight, possibleWeightsToNoteSum);
+}
+
+template<typename Real>
+bool ScaleTraversal<Real>::run(const size_t& maxSteps)
+{
+    const auto& noteCount{ intervalMatrix.noteCount };
+
+    for (size_t step{ 0 }; step != maxSteps && !frames.empty(); ++step, ++stepCount)
+    {
+        auto& frame{ frames.back() };
+
+        if (frame.notesToTraverse.empty())
+        {
+            leaveNode();
+            continue;
+        }
+
+        const auto nextNote{ frame.notesToTraverse.popFirst() };
+        const auto nextWeight{ intervalMatrix.weights[frame.lastNote * noteCount + nextNote] };
+
+        if (isErrorBounded)
+        {
+            const auto nextMass{ errorBudgetFrames.back().mass * nextWeight * frame.possibleWeightsToNoteSum };
+            const auto nextErrorBudget{ takeErrorBudget(nextMass) };
+
+            //ending a child enters no node, so is not counted as a step
+            if (cutWithinErrorBudget(nextNote, nextMass, nextErrorBudget))
+            {
+                --stepCount;
+                continue;
+            }
+
+            possibleNextNotesInPath.erase(nextNote);
+            removeFromRemainingWeightSums(nextNote);
+
+            const auto sumWeightsToNextNote{ 1 / remainingWeightSums[nextNote] };
+
+            //frame is invalidated by pushing, so is not read again
+            enterNodeWithinErrorBudget(nextNote, clampToLimits<Real>(nextWeight * frame.rollingWeight * sumWeightsToNextNote),
+                                       sumWeightsToNextNote, nextMass, nextErrorBudget);
+            continue;
+        }
+
+        possibleNextNotesInPath.erase(nextNote);
+        removeFromRemainingWeightSums(nextNote);
+
+        const auto sumWeightsToNextNote{ 1 / remainingWeightSums[nextNote] };
+        const auto nextRollingWeight{ clampToLimits<Real>(nextWeight * frame.rollingWeight * sumWeightsToNextNote) };
+
+        if (!masses.empty())
+            masses.push_back(masses.back() * nextWeight * frame.possibleWeightsToNoteSum);
+
+        //frame is invalidated by pushing, so is not read again
+        enterNode(nextNote, nextRollingWeight, sumWeightsToNextNote);
+    }
+
+    return frames.empty();
+}
+
+template<typename Real>
+std::vector<TraversalSubtree<Real>> ScaleTraversal<Real>::split(const size_t& depth)
+{
+    std::vector<TraversalSubtree<Real>> subtrees;
+
+    const auto& noteCount{ intervalMatrix.noteCount };
+
+    for (; !frames.empty(); ++stepCount)
+    {
+        auto& frame{ frames.back() };
+
+        if (frame.notesToTraverse.empty())
+        {
+            leaveNode();
+            continue;
+        }
+
+        const auto nextNote{ frame.notesToTraverse.popFirst() };
+        const auto index{ frame.lastNote * noteCount + nextNote };
+        const auto nextWeight{ intervalMatrix.weights[index] };
+        const auto nextMass{ isErrorBounded ? errorBudgetFrames.back().mass * nextWeight * frame.possibleWeightsToNoteSum
+                                            : Real(0) };
+        const auto nextErrorBudget{ isErrorBounded ? takeErrorBudget(nextMass) : Real(0) };
+
+        if (isErrorBounded && cutWithinErrorBudget(nextNote, nextMass, nextErrorBudget))
+        {
+            --stepCount;
+            continue;
+        }
+
+        possibleNextNotesInPath.erase(nextNote);
+        removeFromRemainingWeightSums(nextNote);
+
+        const auto sumWeightsToNextNote{ 1 / remainingWeightSums[nextNote] };
+        const auto nextRollingWeight{ clampToLimits<Real>(nextWeight * frame.rollingWeight * sumWeightsToNextNote) };
+
+        if (frames.size() < depth)
+        {
+            if (isErrorBounded)
+                enterNodeWithinErrorBudget(nextNote, nextRollingWeight, sumWeightsToNextNote, nextMass,
+                                           nextErrorBudget);
+            else
+                enterNode(nextNote, nextRollingWeight, sumWeightsToNextNote);
+            continue;
+        }
+
+        //the log tuning of a node is scaled by the weight of every interval on the path to it
+        auto coefficient{ nextWeight * frame.possibleWeightsToNoteSum };
+
+        for (auto pathFrame{ frames.begin() }; pathFrame + 1 != frames.end(); ++pathFrame)
+            coefficient *= intervalMatrix.weights[pathFrame->lastNote * noteCount + (pathFrame + 1)->lastNote] *
+                           pathFrame->possibleWeightsToNoteSum;
+
+        //the interval to the subtree is counted here, everything below it by the subtree
+        frame.logSize += intervalMatrix.logSizes[index] * nextWeight * frame.possibleWeightsToNoteSum;
+
+        //the error budget of a subtree is its own, and whatever it does not use is not passed on
+        subtrees.push_back({ coefficient, ScaleTraversal(*this, nextNote, nextRollingWeight, sumWeightsToNextNote,
+                                                         nextMass, nextErrorBudget) });
+
+        restoreToRemainingWeightSums(nextNote);
+        possibleNextNotesInPath.insert(nextNote);
+    }
+
+    return subtrees;
+}
+
+template<typename Real>
+double ScaleTraversal<Real>::estimateNodeCount(const size_t& probeCount, const uint64_t& seed, double& variance) const
+{
+    variance = 0;
+
+    if (frames.size() != 1 || stepCount != 0)
+        return 0;
+
+    const auto& noteCount{ intervalMatrix.noteCount };
+
+    std::mt19937_64 generator(seed);
+
+    //the running mean and sum of squared differences from the mean of the estimates, by Welford's method
+    double meanNodeCount{ 0 };
+    double squaredDifferencesSum{ 0 };
+
+    for (size_t probe{ 0 }; probe != probeCount; ++probe)
+    {
+        auto possibleNextNotes{ possibleNextNotesInPath };
+        auto weightSums{ remainingWeightSums };
+
+        auto lastNote{ frames.front().lastNote };
+        auto children{ frames.front().notesToTraverse };
+        auto rollingWeight{ frames.front().rollingWeight };
+
+        double nodeCount{ 1 };
+        double nodesAtDepth{ 1 };
+
+        while (!children.empty())
+        {
+            nodesAtDepth *= children.size();
+            nodeCount += nodesAtDepth;
+
+            auto nextNote{ children.popFirst() };
+            for (auto skipped{ generator() % (children.size() + 1) }; skipped != 0; --skipped)
+                nextNote = children.popFirst();
+
+            possibleNextNotes.erase(nextNote);
+
+            const auto* weightsToNextNote{ &intervalMatrix.weights[nextNote * noteCount] };
+
+            for (auto otherNote{ 0 }; otherNote != noteCount; ++otherNote)
+                weightSums[otherNote] -= weightsToNextNote[otherNote];
+
+            rollingWeight = clampToLimits<Real>(intervalMatrix.weights[lastNote * noteCount + nextNote] * rollingWeight /
+                                                weightSums[nextNote]);
+            lastNote = nextNote;
+            children = SiblingKernels::partitionSiblings(weightsToNextNote, noteCount, possibleNextNotes, rootNote,
+                                                         rollingWeight, weightCutoff).notesToTraverse;
+        }
+
+        const auto difference{ nodeCount - meanNodeCount };
+        meanNodeCount += difference / (double)(probe + 1);
+        squaredDifferencesSum += difference * (nodeCount - meanNodeCount);
+    }
+
+    if (probeCount > 1)
+        variance = squaredDifferencesSum / (double)(probeCount - 1) / (double)probeCount;
+
+    return meanNodeCount;
+}
+
+template<typename Real>
+void ScaleTraversal<Real>::enterNode(const int& lastNote, const Real& rollingWeight,
+                                     const Real& possibleWeightsToNoteSum)
+{
+    const auto& noteCount{ intervalMatrix.noteCount };
+    const auto* weightsToLastNote{ &intervalMatrix.weights[lastNote * noteCount] };
+
+    const auto siblings{ SiblingKernels::partitionSiblings(weightsToLastNote, noteCount, possibleNextNotesInPath,
+                                                           rootNote, rollingWeight, weightCutoff) };
+
+    if constexpr (tuningStatisticsEnabled)
+        TuningCounters::countNode(noteCount - 1 - possibleNextNotesInPath.size(),
+                                  possibleNextNotesInPath.size() - siblings.notesToTraverse.size(),
+                                  possibleNextNotesInPath.contains(rootNote));
+
+    if (!masses.empty())
+    {
+        const auto containsRootNote{ possibleNextNotesInPath.contains(rootNote) };
+
+        //rootNote ends the path rather than cutting it
+        if (possibleNextNotesInPath.size() - siblings.notesToTraverse.size() > (containsRootNote ? 1 : 0))
+            cutMass += masses.back() * possibleWeightsToNoteSum *
+                       (siblings.prunedWeightSum - (containsRootNote ? weightsToLastNote[rootNote] : 0));
+    }
+
+    frames.push_back({ lastNote, siblings.notesToTraverse, rollingWeight, possibleWeightsToNoteSum,
+                       intervalMatrix.logSizes[lastNote * noteCount + rootNote] * siblings.prunedWeightSum *
+                       possibleWeightsToNoteSum });
+}
+
+template<typename Real>
+void ScaleTraversal<Real>::leaveNode()
+{
+    const auto childLogSize{ frames.back().logSize };
+    const auto childNote{ frames.back().lastNote };
+
+    frames.pop_back();
+
+    if (!masses.empty())
+        masses.pop_back();
+
+    if (isErrorBounded)
+    {
+        const auto childErrorBudget{ errorBudgetFrames.back().errorBudget };
+        errorBudgetFrames.pop_back();
+
+        //whatever error budget the child did not use is left for its later siblings
+        if (!errorBudgetFrames.empty())
+            errorBudgetFrames.back().errorBudget += childErrorBudget;
+    }
+
+    if (frames.empty())
+    {
+        logTuning = childLogSize;
+        return;
+    }
+
+    auto& frame{ frames.back() };
+    const auto index{ frame.lastNote * intervalMatrix.noteCount + childNote };
+
+    frame.logSize += (intervalMatrix.logSizes[index] + childLogSize) * intervalMatrix.weights[index] *
+                     frame.possibleWeightsToNoteSum;
+
+    restoreToRemainingWeightSums(childNote);
+    possibleNextNotesInPath.insert(childNote);
+}
+
+template<typename Real>
+void ScaleTraversal<Real>::enterNodeWithinErrorBudget(const int& lastNote, const Real& rollingWeight,
+                                                      const Real& possibleWeightsToNoteSum, const Real& mass,
+                                                      const Real& errorBudget)
+{
+    enterNode(lastNote, rollingWeight, possibleWeightsToNoteSum);
+
+    auto& frame{ frames.back() };
+    const auto& noteCount{ intervalMatrix.noteCount };
+    const auto* weightsToLastNote{ &intervalMatrix.weights[lastNote * noteCount] };
+    const auto* logSizesToRootNote{ &intervalMatrix.logSizes[rootNote] };
+
+    //every step below a grandchild is between two of the notes still reachable, and goes on to another
+    //rather than ending at rootNote with at most 1 - minEndingShare of the weight
+    Real maxDeviation{ 0 };
+    Real minEndingShare{ 1 };
+    size_t reachableCount{ 0 };
+
+    for (auto notes{ possibleNextNotesInPath }; !notes.empty();)
+    {
+        const auto fromNote{ notes.popFirst() };
+
+        if (fromNote == rootNote)
+            continue;
+
+        const auto* logSizesFromNote{ &intervalMatrix.logSizes[fromNote * noteCount] };
+        const auto logSizeToRootNote{ logSizesToRootNote[fromNote * noteCount] };
+
+        //deviations are antisymmetric, so the greatest is also the greatest in magnitude
+        for (auto toNotes{ notes }; !toNotes.empty();)
+        {
+            const auto toNote{ toNotes.popFirst() };
+
+            maxDeviation = std::max(maxDeviation, std::abs(logSizesFromNote[toNote] +
+                                                           logSizesToRootNote[toNote * noteCount] - logSizeToRootNote));
+        }
+
+        ++reachableCount;
+        minEndingShare = std::min(minEndingShare, intervalMatrix.weights[fromNote * noteCount + rootNote] /
+                                                  remainingWeightSums[fromNote]);
+    }
+
+    //the subtree of a grandchild passes through at most reachableCount - 2 more notes, the kth step
+    //through which is taken by at most (1 - minEndingShare)^k of its weight
+    Real grandchildDeviation{ 0 };
+    Real continuingShare{ 1 };
+
+    for (size_t step{ 2 }; step < reachableCount; ++step)
+    {
+        continuingShare *= 1 - minEndingShare;
+        grandchildDeviation += continuingShare;
+    }
+
+    grandchildDeviation *= maxDeviation;
+
+    Real sharesSum{ 0 };
+
+    for (auto notesToTraverse{ frame.notesToTraverse }; !notesToTraverse.empty();)
+        sharesSum += errorBudgetShare(mass * weightsToLastNote[notesToTraverse.popFirst()] * possibleWeightsToNoteSum);
+
+    errorBudgetFrames.push_back({ mass, errorBudget, sharesSum, grandchildDeviation });
+
+    //children are first ended wherever their error fits in their share of the whole budget, which leaves
+    //what they did not use to the children which are traversed
+    for (auto notesToTraverse{ frame.notesToTraverse }; !notesToTraverse.empty();)
+    {
+        const auto childNote{ notesToTraverse.popFirst() };
+        const auto childMass{ mass * weightsToLastNote[childNote] * possibleWeightsToNoteSum };
+        const auto share{ errorBudgetShare(childMass) };
+        const auto childErrorBudget{ errorBudget * share / sharesSum };
+
+        auto& budgetFrame{ errorBudgetFrames.back() };
+        budgetFrame.errorBudget -= childErrorBudget;
+
+        if (cutWithinErrorBudget(childNote, childMass, childErrorBudget))
+        {
+            frame.notesToTraverse.erase(childNote);
+            budgetFrame.unenteredShares -= share;
+        }
+        else
+            budgetFrame.errorBudget += childErrorBudget;
+    }
+}
+
+template<typename Real>
+Real ScaleTraversal<Real>::takeErrorBudget(const Real& childMass)
+{
+    auto& frame{ errorBudgetFrames.back() };
+
+    const auto share{ errorBudgetShare(childMass) };
+    const auto childErrorBudget{ frame.unenteredShares > share ? frame.errorBudget * share / frame.unenteredShares
+                                                               : frame.errorBudget };
+
+    frame.errorBudget -= childErrorBudget;
+    frame.unenteredShares -= share;
+
+    return childErrorBudget;
+}
+
+template<typename Real>
+bool ScaleTraversal<Real>::cutWithinErrorBudget(const int& childNote, const Real& childMass,
+                                                const Real& childErrorBudget)
+{
+    const auto& noteCount{ intervalMatrix.noteCount };
+    const auto* weightsFromChild{ &intervalMatrix.weights[childNote * noteCount] };
+    const auto* logSizesFromChild{ &intervalMatrix.logSizes[childNote * noteCount] };
+    const auto* logSizesToRootNote{ &intervalMatrix.logSizes[rootNote] };
+    const auto logSizeToRootNote{ logSizesToRootNote[childNote * noteCount] };
+
+    //the steps from the child are known, so only the subtrees of its children are bounded
+    Real weightedDeviationSum{ 0 };
+
+    for (auto notes{ possibleNextNotesInPath }; !notes.empty();)
+    {
+        const auto nextNote{ notes.popFirst() };
+
+        if (nextNote != rootNote && nextNote != childNote)
+            weightedDeviationSum += weightsFromChild[nextNote] * (logSizesFromChild[nextNote] +
+                                                                  logSizesToRootNote[nextNote * noteCount] - logSizeToRootNote);
+    }
+
+    const auto continuingShare{ 1 - weightsFromChild[rootNote] / remainingWeightSums[childNote] };
+    const auto childError{ childMass * continuingShare * errorBudgetFrames.back().grandchildDeviation };
+
+    if (childError > childErrorBudget)
+        return false;
+
+    if constexpr (tuningStatisticsEnabled)
+        TuningCounters::countCutLeaves(1);
+
+    auto& frame{ frames.back() };
+    const auto index{ frame.lastNote * noteCount + childNote };
+
+    //each path from the child is taken to end at the note after it, then go straight to rootNote
+    frame.logSize += (intervalMatrix.logSizes[index] + logSizeToRootNote +
+                      weightedDeviationSum / remainingWeightSums[childNote]) *
+                     intervalMatrix.weights[index] * frame.possibleWeightsToNoteSum;
+
+    errorBudgetFrames.back().errorBudget += childErrorBudget - childError;
+
+    return true;
+}
+
+template<typename Real>
+void ScaleTraversal<Real>::removeFromRemainingWeightSums(const int& note)
+{
+    //weights are symmetric, so the weights from note to every other note are a contiguous row
+    const auto* weightsToNote{ &intervalMatrix.weights[note * intervalMatrix.noteCount] };
+
+    for (auto otherNote{ 0 }; otherNote != intervalMatrix.noteCount; ++otherNote)
+        remainingWeightSums[otherNote] -= weightsToNote[otherNote];
+}
+
+template<typename Real>
+void ScaleTraversal<Real>::restoreToRemainingWeightSums(const int& note)
+{
+    const auto* weightsToNote{ &intervalMatrix.weights[note * intervalMatrix.noteCount] };
+
+    for (auto otherNote{ 0 }; otherNote != intervalMatrix.noteCount; ++otherNote)
+        remainingWeightSums[otherNote] += weightsToNote[otherNote];
+}
+
+template class ScaleTraversal<float>;
+template class ScaleTraversal<double>;
+template class ScaleTraversal<long double>;
\ No newline at end of file
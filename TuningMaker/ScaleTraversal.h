@@ -0,0 +1,254 @@
+#pragma once
+#include "Utilities.h"
+#include "NoteSet.h"
+#include "SiblingKernels.h"
+#include "TuningStatistics.h"
+
+/*
+  A dense copy of the interval from every note in a scale to every other note, with each property of the
+  intervals stored in its own array so that a traversal reads the intervals to one note contiguously and
+  without branches. The interval from noteFrom to noteTo is at index noteTo * noteCount + noteFrom. Both
+  directions of every interval are stored, so the reciprocal of sizes[a * noteCount + b] is
+  sizes[b * noteCount + a]. Intervals from a note to itself have size 1 and weight 0.
+*/
+template<typename Real>
+struct IntervalMatrix
+{
+    size_t noteCount{ 0 };
+    std::vector<Real> sizes;
+    /*
+      The base 2 logarithm of each size.
+    */
+    std::vector<Real> logSizes;
+    std::vector<Real> weights;
+};
+
+template<typename Real>
+struct TraversalSubtree;
+
+/*
+  The traversal of a scale which tunes one note against one root note, run over an explicit stack of
+  frames rather than by recursion. It sums the weighted log sizes of intervals along every path from note,
+  as TuningEngine::logarithmic does, but can be stopped after any number of steps and resumed later by
+  calling run() again, so a long traversal can be time-sliced or handed to another thread between calls.
+  A traversal reads the IntervalMatrix it was constructed with, which must outlive it.
+*/
+template<typename Real>
+class ScaleTraversal
+{
+public:
+    /*
+      Constructs a traversal from note to rootNote of the scale whose intervals are in matrix. Paths whose
+      rolling weight falls to or below weightCutoff are treated as if they had reached rootNote.
+
+      If maxLogError is greater than 0, weightCutoff is ignored, and the traversal instead ends each child of
+      a node, as if every path from it went on to one more note and then to rootNote, when the most that
+      could change the log tuning by doing so fits in the child's share of the error budget. That bound is
+      taken from the sizes of the intervals between the notes still reachable below the node, measured
+      against their intervals to rootNote, and from the least share of weight any of those notes gives to
+      ending the path at rootNote. The log tuning is then within maxLogError of the log tuning of a
+      traversal which prunes nothing. The error budget of a node is shared between its children in
+      proportion to the fourth root of their share of the weight of every path, so light children are
+      ended first, and whatever a child does not use is passed on to its siblings.
+
+      If countsCutMass is true and maxLogError is not greater than 0, the traversal also counts the share of
+      the weight of every path which weightCutoff cuts, returned by getCutMass().
+    */
+    ScaleTraversal(const IntervalMatrix<Real>& matrix, const int& rootNote, const int& note, const Real& weightCutoff,
+                   const Real& maxLogError = 0, const bool& countsCutMass = false);
+
+    /*
+      Takes up to maxSteps steps of the traversal, where a step is entering or leaving one node of the tree
+      of paths, and returns true if the traversal has finished.
+    */
+    bool run(const size_t& maxSteps = std::numeric_limits<size_t>::max());
+
+    /*
+      Traverses the first depth levels of the tree of paths of a traversal which has not been run, and
+      returns every node below them as a separate traversal instead of entering it, so that the subtrees
+      can be run independently, for example on different threads. Once every subtree has been run, the
+      log tuning of the whole traversal is getLogTuning() plus the sum of each subtree's coefficient
+      multiplied by its getLogTuning(). The subtrees read the same IntervalMatrix as this traversal, and
+      don't count the mass they cut.
+    */
+    std::vector<TraversalSubtree<Real>> split(const size_t& depth);
+
+    /*
+      Estimates the number of nodes in the tree of paths of a traversal which has not been run, without
+      running it, by Knuth's method: each of probeCount random paths from the first node chooses uniformly
+      among the children of every node it reaches, and estimates the size of the tree as the sum over its
+      depths of the product of the numbers of children it saw. The mean of these estimates is unbiased.
+      The variance of the mean is written to variance. The paths chosen depend only on seed.
+    */
+    double estimateNodeCount(const size_t& probeCount, const uint64_t& seed, double& variance) const;
+
+    /*
+      Returns true if the traversal has finished.
+    */
+    inline bool isFinished() const
+    {
+        return frames.empty();
+    }
+
+    /*
+      Returns the number of steps taken so far.
+    */
+    inline size_t getStepCount() const
+    {
+        return stepCount;
+    }
+
+    /*
+      Returns the base 2 logarithm of the tuning of note relative to rootNote. Only meaningful once the
+      traversal has finished.
+    */
+    inline Real getLogTuning() const
+    {
+        return logTuning;
+    }
+
+    /*
+      Returns the share of the weight of every path from note which weightCutoff has cut so far, treating it
+      as if it had reached rootNote, if the traversal was constructed to count it, and otherwise 0. It is
+      exactly 0 if nothing has been cut.
+    */
+    inline Real getCutMass() const
+    {
+        return cutMass;
+    }
+
+private:
+    /*
+      The state of one node of the tree of paths: the path so far ends at lastNote, and the children of the
+      node still to be traversed are in notesToTraverse.
+    */
+    struct Frame
+    {
+        int lastNote;
+        NoteSet notesToTraverse;
+        Real rollingWeight;
+        /*
+          The reciprocal of the sum of weights from lastNote to every note that may follow it.
+        */
+        Real possibleWeightsToNoteSum;
+        /*
+          The weighted sum of log sizes of the children finished so far.
+        */
+        Real logSize;
+    };
+
+    /*
+      What a node of the current path holds when the error is bounded, kept apart from its Frame so that
+      traversals pruned by weightCutoff push and copy nothing more.
+    */
+    struct ErrorBudgetFrame
+    {
+        /*
+          The share of the weight of every path from note which passes through the node.
+        */
+        Real mass;
+        /*
+          The error budget left for the children not yet entered, and the sum of their shares of it.
+        */
+        Real errorBudget;
+        Real unenteredShares;
+        /*
+          The most the log size of the subtree of a grandchild can differ from that of the interval from the
+          grandchild to rootNote.
+        */
+        Real grandchildDeviation;
+    };
+
+    const IntervalMatrix<Real>& intervalMatrix;
+    int rootNote;
+    Real weightCutoff;
+    bool isErrorBounded;
+
+    /*
+      The notes not yet in the current path.
+    */
+    NoteSet possibleNextNotesInPath;
+    /*
+      For every note, the sum of the weights from it to every note in possibleNextNotesInPath.
+    */
+    std::vector<Real> remainingWeightSums;
+    /*
+      The path from note to the current node, with the current node on top.
+    */
+    std::vector<Frame> frames;
+    /*
+      Parallel to frames when the error is bounded, and otherwise empty.
+    */
+    std::vector<ErrorBudgetFrame> errorBudgetFrames;
+    /*
+      Parallel to frames when the mass cut is counted, the share of the weight of every path from note which
+      passes through each node, and otherwise empty.
+    */
+    std::vector<Real> masses;
+
+    size_t stepCount{ 0 };
+    Real logTuning{ 0 };
+    Real cutMass{ 0 };
+
+    /*
+      Constructs a traversal of the subtree below the node of parent reached at lastNote, from the state
+      parent is in when that node is entered.
+    */
+    ScaleTraversal(const ScaleTraversal& parent, const int& lastNote, const Real& rollingWeight,
+                   const Real& possibleWeightsToNoteSum, const Real& mass, const Real& errorBudget);
+
+    /*
+      Pushes the node reached at lastNote, finding which of its children end the path.
+    */
+    void enterNode(const int& lastNote, const Real& rollingWeight, const Real& possibleWeightsToNoteSum);
+
+    /*
+      Pushes the node reached at lastNote when the error is bounded, along with its ErrorBudgetFrame, and
+      ends every child whose error fits in its share of errorBudget. mass is the node's share of the weight
+      of every path from note.
+    */
+    void enterNodeWithinErrorBudget(const int& lastNote, const Real& rollingWeight,
+                                    const Real& possibleWeightsToNoteSum, const Real& mass, const Real& errorBudget);
+
+    /*
+      Removes the share of a child of mass childMass from the error budget of the node on top of the stack,
+      and returns it.
+    */
+    Real takeErrorBudget(const Real& childMass);
+
+    /*
+      If the error of ending the child childNote, of mass childMass, of the node on top of the stack fits in
+      childErrorBudget, adds the child to the node's log size as if every path from it went on to one more
+      note and then to rootNote, returns what it did not use of childErrorBudget to the node, and returns
+      true.
+    */
+    bool cutWithinErrorBudget(const int& childNote, const Real& childMass, const Real& childErrorBudget);
+
+    /*
+      Pops the node on top of the stack, adding its contribution to its parent, or to logTuning if it is
+      the first node.
+    */
+    void leaveNode();
+
+    /*
+      Subtracts the weights from note to every other note from remainingWeightSums, after note has been
+      removed from possibleNextNotesInPath.
+    */
+    void removeFromRemainingWeightSums(const int& note);
+
+    /*
+      Undoes removeFromRemainingWeightSums().
+    */
+    void restoreToRemainingWeightSums(const int& note);
+};
+
+/*
+  A subtree returned by ScaleTraversal::split(), and the factor its log tuning is multiplied by in the log
+  tuning of the traversal it was split from.
+*/
+template<typename Real>
+struct TraversalSubtree
+{
+    Real coefficient;
+    ScaleTraversal<Real> traversal;
+};
\ No newline at end of file
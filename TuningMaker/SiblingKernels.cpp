@@ -0,0 +1,703 @@
+#include "SiblingKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIBLING_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIBLING_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+//GCC and Clang only emit AVX2 instructions in functions which ask for them, MSVC emits them anywhere
+#if defined(SIBLING_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIBLING_KERNELS_AVX2 __attribute__((target("avx2")))
+#else
+#define SIBLING_KERNELS_AVX2
+#endif
+
+/*
+  log2(m) for m in [sqrt(1/2), sqrt(2)] is calculated as 2 / ln(2) * atanh(t), where t = (m - 1) / (m + 1)
+  and atanh(t) = t + t^3 / 3 + t^5 / 5 + ... These are the coefficients of that series in t^2.
+*/
+static constexpr long double log2SeriesCoefficients[]{ 1.0L, 1.0L / 3, 1.0L / 5, 1.0L / 7,
+                                                       1.0L / 9, 1.0L / 11, 1.0L / 13, 1.0L / 15 };
+
+static constexpr long double twoOverLn2{ 2.88539008177792681472L };
+static constexpr long double ln2{ 0.69314718055994530942L };
+static constexpr long double squareRootOfTwo{ 1.41421356237309504880L };
+
+/*
+  Returns the number of terms of log2SeriesCoefficients used at accuracy.
+*/
+static int log2SeriesTerms(const ApproximationAccuracy& accuracy)
+{
+    switch (accuracy)
+    {
+    case ApproximationAccuracy::low:
+        return 2;
+    case ApproximationAccuracy::medium:
+        return 5;
+    default:
+        return 8;
+    }
+}
+
+/*
+  Returns the degree of the Taylor series of e^x, for |x| <= ln(2) / 2, used by approximateExp2() at
+  accuracy.
+*/
+static int exp2TaylorDegree(const ApproximationAccuracy& accuracy)
+{
+    switch (accuracy)
+    {
+    case ApproximationAccuracy::low:
+        return 4;
+    case ApproximationAccuracy::medium:
+        return 7;
+    default:
+        return 11;
+    }
+}
+
+/*
+  Returns true if the CPU running the program, and its operating system, support AVX2.
+*/
+static bool cpuSupportsAvx2()
+{
+#if defined(SIBLING_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    static const bool supported{ (bool)__builtin_cpu_supports("avx2") };
+#elif defined(SIBLING_KERNELS_X86)
+    static const bool supported{ []()
+        {
+            int registers[4];
+
+            __cpuid(registers, 1);
+            const auto osSavesAvxRegisters{ (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6 };
+
+            __cpuidex(registers, 7, 0);
+
+            return osSavesAvxRegisters && (registers[1] & (1 << 5)) != 0;
+        }()
+    };
+#else
+    static const bool supported{ false };
+#endif
+
+    return supported;
+}
+
+template<typename Real>
+static SiblingPartition<Real> partitionSiblingsScalar(const Real* weightsToLastNote, const NoteSet& possibleNextNotes,
+                                                      const int& rootNote, const Real& rollingWeight,
+                                                      const Real& weightCutoff)
+{
+    SiblingPartition<Real> partition{ 0, possibleNextNotes };
+
+    for (auto remainingNotes{ possibleNextNotes }; !remainingNotes.empty();)
+    {
+        const auto nextNote{ remainingNotes.popFirst() };
+        const auto nextWeight{ weightsToLastNote[nextNote] };
+
+        if (nextNote == rootNote || nextWeight * rollingWeight <= weightCutoff)
+        {
+            partition.prunedWeightSum += nextWeight;
+            partition.notesToTraverse.erase(nextNote);
+        }
+    }
+
+    return partition;
+}
+
+template<typename Real>
+static Real weightedLog2SumScalar(const Real* weights, const Real* values, const size_t& count,
+                                  const ApproximationAccuracy& accuracy)
+{
+    Real sum{ 0 };
+
+    for (auto index{ 0 }; index != count; ++index)
+        sum += weights[index] * SiblingKernels::approximateLog2(values[index], accuracy);
+
+    return sum;
+}
+
+#ifdef SIBLING_KERNELS_X86
+/*
+  The AVX2 kernels process one 64 note word of a NoteSet at a time, in chunks of 4 doubles or 8 floats
+  which never cross a word, followed by a scalar tail if the scale ends part way through a chunk.
+*/
+
+SIBLING_KERNELS_AVX2
+static double horizontalSum(const __m256d& values)
+{
+    const auto halves{ _mm_add_pd(_mm256_castpd256_pd128(values), _mm256_extractf128_pd(values, 1)) };
+
+    return _mm_cvtsd_f64(_mm_add_sd(halves, _mm_unpackhi_pd(halves, halves)));
+}
+
+SIBLING_KERNELS_AVX2
+static float horizontalSum(const __m256& values)
+{
+    auto halves{ _mm_add_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1)) };
+    halves = _mm_add_ps(halves, _mm_movehl_ps(halves, halves));
+
+    return _mm_cvtss_f32(_mm_add_ss(halves, _mm_shuffle_ps(halves, halves, 1)));
+}
+
+SIBLING_KERNELS_AVX2
+static SiblingPartition<double> partitionSiblingsAvx2(const double* weightsToLastNote, const size_t& noteCount,
+                                                      const NoteSet& possibleNextNotes, const int& rootNote,
+                                                      const double& rollingWeight, const double& weightCutoff)
+{
+    constexpr int lanes{ 4 };
+
+    SiblingPartition<double> partition{ 0, possibleNextNotes };
+
+    NoteSet rootNoteSet;
+    rootNoteSet.insert(rootNote);
+
+    const auto rollingWeights{ _mm256_set1_pd(rollingWeight) };
+    const auto weightCutoffs{ _mm256_set1_pd(weightCutoff) };
+    const auto laneBits{ _mm256_set_epi64x(8, 4, 2, 1) };
+
+    auto prunedWeightSums{ _mm256_setzero_pd() };
+    double tailPrunedWeightSum{ 0 };
+
+    for (auto word{ 0 }; word != NoteSet::wordCount && word * NoteSet::bitsPerWord < noteCount; ++word)
+    {
+        const auto remainingWord{ possibleNextNotes.getWord(word) };
+        if (remainingWord == 0)
+            continue;
+
+        const auto rootNoteWord{ rootNoteSet.getWord(word) };
+        uint64_t prunedWord{ 0 };
+
+        const size_t firstNote{ (size_t)word * NoteSet::bitsPerWord };
+        const auto endNote{ std::min(noteCount, firstNote + NoteSet::bitsPerWord) };
+
+        auto note{ firstNote };
+        for (; note + lanes <= endNote; note += lanes)
+        {
+            const auto shift{ note - firstNote };
+            const auto remainingLanes{ (remainingWord >> shift) & 0xF };
+            if (remainingLanes == 0)
+                continue;
+
+            const auto weights{ _mm256_loadu_pd(weightsToLastNote + note) };
+            const auto belowCutoff{ _mm256_cmp_pd(_mm256_mul_pd(weights, rollingWeights), weightCutoffs, _CMP_LE_OQ) };
+
+            const auto prunedLanes{ ((uint64_t)_mm256_movemask_pd(belowCutoff) | ((rootNoteWord >> shift) & 0xF)) &
+                                    remainingLanes };
+            prunedWord |= prunedLanes << shift;
+
+            const auto prunedLaneMask{ _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(prunedLanes), laneBits),
+                                                          laneBits) };
+            prunedWeightSums = _mm256_add_pd(prunedWeightSums, _mm256_and_pd(weights, _mm256_castsi256_pd(prunedLaneMask)));
+        }
+
+        for (; note != endNote; ++note)
+            if (((remainingWord >> (note - firstNote)) & 1) &&
+                (note == rootNote || weightsToLastNote[note] * rollingWeight <= weightCutoff))
+            {
+                prunedWord |= uint64_t(1) << (note - firstNote);
+                tailPrunedWeightSum += weightsToLastNote[note];
+            }
+
+        partition.notesToTraverse.setWord(word, remainingWord & ~prunedWord);
+    }
+
+    partition.prunedWeightSum = horizontalSum(prunedWeightSums) + tailPrunedWeightSum;
+
+    return partition;
+}
+
+SIBLING_KERNELS_AVX2
+static SiblingPartition<float> partitionSiblingsAvx2(const float* weightsToLastNote, const size_t& noteCount,
+                                                     const NoteSet& possibleNextNotes, const int& rootNote,
+                                                     const float& rollingWeight, const float& weightCutoff)
+{
+    constexpr int lanes{ 8 };
+
+    SiblingPartition<float> partition{ 0, possibleNextNotes };
+
+    NoteSet rootNoteSet;
+    rootNoteSet.insert(rootNote);
+
+    const auto rollingWeights{ _mm256_set1_ps(rollingWeight) };
+    const auto weightCutoffs{ _mm256_set1_ps(weightCutoff) };
+    const auto laneBits{ _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1) };
+
+    auto prunedWeightSums{ _mm256_setzero_ps() };
+    float tailPrunedWeightSum{ 0 };
+
+    for (auto word{ 0 }; word != NoteSet::wordCount && word * NoteSet::bitsPerWord < noteCount; ++word)
+    {
+        const auto remainingWord{ possibleNextNotes.getWord(word) };
+        if (remainingWord == 0)
+            continue;
+
+        const auto rootNoteWord{ rootNoteSet.getWord(word) };
+        uint64_t prunedWord{ 0 };
+
+        const size_t firstNote{ (size_t)word * NoteSet::bitsPerWord };
+        const auto endNote{ std::min(noteCount, firstNote + NoteSet::bitsPerWord) };
+
+        auto note{ firstNote };
+        for (; note + lanes <= endNote; note += lanes)
+        {
+            const auto shift{ note - firstNote };
+            const auto remainingLanes{ (remainingWord >> shift) & 0xFF };
+            if (remainingLanes == 0)
+                continue;
+
+            const auto weights{ _mm256_loadu_ps(weightsToLastNote + note) };
+            const auto belowCutoff{ _mm256_cmp_ps(_mm256_mul_ps(weights, rollingWeights), weightCutoffs, _CMP_LE_OQ) };
+
+            const auto prunedLanes{ ((uint64_t)_mm256_movemask_ps(belowCutoff) | ((rootNoteWord >> shift) & 0xFF)) &
+                                    remainingLanes };
+            prunedWord |= prunedLanes << shift;
+
+            const auto prunedLaneMask{ _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)prunedLanes), laneBits),
+                                                          laneBits) };
+            prunedWeightSums = _mm256_add_ps(prunedWeightSums, _mm256_and_ps(weights, _mm256_castsi256_ps(prunedLaneMask)));
+        }
+
+        for (; note != endNote; ++note)
+            if (((remainingWord >> (note - firstNote)) & 1) &&
+                (note == rootNote || weightsToLastNote[note] * rollingWeight <= weightCutoff))
+            {
+                prunedWord |= uint64_t(1) << (note - firstNote);
+                tailPrunedWeightSum += weightsToLastNote[note];
+            }
+
+        partition.notesToTraverse.setWord(word, remainingWord & ~prunedWord);
+    }
+
+    partition.prunedWeightSum = horizontalSum(prunedWeightSums) + tailPrunedWeightSum;
+
+    return partition;
+}
+
+SIBLING_KERNELS_AVX2
+static __m256d log2Avx2(const __m256d& values, const int& terms)
+{
+    const auto one{ _mm256_set1_pd(1) };
+    const auto exponentOffset{ _mm256_set1_pd(0x1p52) };
+
+    //values = mantissa * 2^exponent with mantissa in [1, 2)
+    const auto bits{ _mm256_castpd_si256(values) };
+    auto mantissa{ _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF)),
+                                                       _mm256_set1_epi64x(0x3FF0000000000000))) };
+    auto exponent{ _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52),
+                                                                     _mm256_castpd_si256(exponentOffset))),
+                                 _mm256_add_pd(exponentOffset, _mm256_set1_pd(1023))) };
+
+    //move mantissa into [sqrt(1/2), sqrt(2)]
+    const auto mantissaIsLarge{ _mm256_cmp_pd(mantissa, _mm256_set1_pd((double)squareRootOfTwo), _CMP_GT_OQ) };
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), mantissaIsLarge);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(mantissaIsLarge, one));
+
+    const auto t{ _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one)) };
+    const auto tSquared{ _mm256_mul_pd(t, t) };
+
+    auto series{ _mm256_set1_pd((double)log2SeriesCoefficients[terms - 1]) };
+    for (auto term{ terms - 2 }; term >= 0; --term)
+        series = _mm256_add_pd(_mm256_mul_pd(series, tSquared), _mm256_set1_pd((double)log2SeriesCoefficients[term]));
+
+    return _mm256_add_pd(exponent, _mm256_mul_pd(_mm256_mul_pd(t, series), _mm256_set1_pd((double)twoOverLn2)));
+}
+
+SIBLING_KERNELS_AVX2
+static __m256 log2Avx2(const __m256& values, const int& terms)
+{
+    const auto one{ _mm256_set1_ps(1) };
+
+    const auto bits{ _mm256_castps_si256(values) };
+    auto mantissa{ _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                       _mm256_set1_epi32(0x3F800000))) };
+    auto exponent{ _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 23)), _mm256_set1_ps(127)) };
+
+    const auto mantissaIsLarge{ _mm256_cmp_ps(mantissa, _mm256_set1_ps((float)squareRootOfTwo), _CMP_GT_OQ) };
+    mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, _mm256_set1_ps(0.5f)), mantissaIsLarge);
+    exponent = _mm256_add_ps(exponent, _mm256_and_ps(mantissaIsLarge, one));
+
+    const auto t{ _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one)) };
+    const auto tSquared{ _mm256_mul_ps(t, t) };
+
+    auto series{ _mm256_set1_ps((float)log2SeriesCoefficients[terms - 1]) };
+    for (auto term{ terms - 2 }; term >= 0; --term)
+        series = _mm256_add_ps(_mm256_mul_ps(series, tSquared), _mm256_set1_ps((float)log2SeriesCoefficients[term]));
+
+    return _mm256_add_ps(exponent, _mm256_mul_ps(_mm256_mul_ps(t, series), _mm256_set1_ps((float)twoOverLn2)));
+}
+
+SIBLING_KERNELS_AVX2
+static double weightedLog2SumAvx2(const double* weights, const double* values, const size_t& count,
+                                  const ApproximationAccuracy& accuracy)
+{
+    const auto terms{ log2SeriesTerms(accuracy) };
+
+    auto sums{ _mm256_setzero_pd() };
+
+    size_t index{ 0 };
+    for (; index + 4 <= count; index += 4)
+        sums = _mm256_add_pd(sums, _mm256_mul_pd(_mm256_loadu_pd(weights + index),
+                                                 log2Avx2(_mm256_loadu_pd(values + index), terms)));
+
+    return horizontalSum(sums) + weightedLog2SumScalar(weights + index, values + index, count - index, accuracy);
+}
+
+SIBLING_KERNELS_AVX2
+static float weightedLog2SumAvx2(const float* weights, const float* values, const size_t& count,
+                                 const ApproximationAccuracy& accuracy)
+{
+    const auto terms{ log2SeriesTerms(accuracy) };
+
+    auto sums{ _mm256_setzero_ps() };
+
+    size_t index{ 0 };
+    for (; index + 8 <= count; index += 8)
+        sums = _mm256_add_ps(sums, _mm256_mul_ps(_mm256_loadu_ps(weights + index),
+                                                 log2Avx2(_mm256_loadu_ps(values + index), terms)));
+
+    return horizontalSum(sums) + weightedLog2SumScalar(weights + index, values + index, count - index, accuracy);
+}
+#endif
+
+#ifdef SIBLING_KERNELS_NEON
+/*
+  The NEON kernels mirror the AVX2 kernels with 2 doubles or 4 floats per chunk.
+*/
+
+static SiblingPartition<double> partitionSiblingsNeon(const double* weightsToLastNote, const size_t& noteCount,
+                                                      const NoteSet& possibleNextNotes, const int& rootNote,
+                                                      const double& rollingWeight, const double& weightCutoff)
+{
+    constexpr int lanes{ 2 };
+
+    SiblingPartition<double> partition{ 0, possibleNextNotes };
+
+    NoteSet rootNoteSet;
+    rootNoteSet.insert(rootNote);
+
+    const auto rollingWeights{ vdupq_n_f64(rollingWeight) };
+    const auto weightCutoffs{ vdupq_n_f64(weightCutoff) };
+    const uint64_t laneBitValues[lanes]{ 1, 2 };
+    const auto laneBits{ vld1q_u64(laneBitValues) };
+
+    auto prunedWeightSums{ vdupq_n_f64(0) };
+    double tailPrunedWeightSum{ 0 };
+
+    for (auto word{ 0 }; word != NoteSet::wordCount && word * NoteSet::bitsPerWord < noteCount; ++word)
+    {
+        const auto remainingWord{ possibleNextNotes.getWord(word) };
+        if (remainingWord == 0)
+            continue;
+
+        const auto rootNoteWord{ rootNoteSet.getWord(word) };
+        uint64_t prunedWord{ 0 };
+
+        const size_t firstNote{ (size_t)word * NoteSet::bitsPerWord };
+        const auto endNote{ std::min(noteCount, firstNote + NoteSet::bitsPerWord) };
+
+        auto note{ firstNote };
+        for (; note + lanes <= endNote; note += lanes)
+        {
+            const auto shift{ note - firstNote };
+            const auto remainingLanes{ (remainingWord >> shift) & 0x3 };
+            if (remainingLanes == 0)
+                continue;
+
+            const auto weights{ vld1q_f64(weightsToLastNote + note) };
+            const auto belowCutoff{ vcleq_f64(vmulq_f64(weights, rollingWeights), weightCutoffs) };
+
+            const auto prunedLanes{ (vaddvq_u64(vandq_u64(belowCutoff, laneBits)) | ((rootNoteWord >> shift) & 0x3)) &
+                                    remainingLanes };
+            prunedWord |= prunedLanes << shift;
+
+            const auto prunedLaneMask{ vceqq_u64(vandq_u64(vdupq_n_u64(prunedLanes), laneBits), laneBits) };
+            prunedWeightSums = vaddq_f64(prunedWeightSums,
+                                         vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(weights), prunedLaneMask)));
+        }
+
+        for (; note != endNote; ++note)
+            if (((remainingWord >> (note - firstNote)) & 1) &&
+                (note == rootNote || weightsToLastNote[note] * rollingWeight <= weightCutoff))
+            {
+                prunedWord |= uint64_t(1) << (note - firstNote);
+                tailPrunedWeightSum += weightsToLastNote[note];
+            }
+
+        partition.notesToTraverse.setWord(word, remainingWord & ~prunedWord);
+    }
+
+    partition.prunedWeightSum = vaddvq_f64(prunedWeightSums) + tailPrunedWeightSum;
+
+    return partition;
+}
+
+static SiblingPartition<float> partitionSiblingsNeon(const float* weightsToLastNote, const size_t& noteCount,
+                                                     const NoteSet& possibleNextNotes, const int& rootNote,
+                                                     const float& rollingWeight, const float& weightCutoff)
+{
+    constexpr int lanes{ 4 };
+
+    SiblingPartition<float> partition{ 0, possibleNextNotes };
+
+    NoteSet rootNoteSet;
+    rootNoteSet.insert(rootNote);
+
+    const auto rollingWeights{ vdupq_n_f32(rollingWeight) };
+    const auto weightCutoffs{ vdupq_n_f32(weightCutoff) };
+    const uint32_t laneBitValues[lanes]{ 1, 2, 4, 8 };
+    const auto laneBits{ vld1q_u32(laneBitValues) };
+
+    auto prunedWeightSums{ vdupq_n_f32(0) };
+    float tailPrunedWeightSum{ 0 };
+
+    for (auto word{ 0 }; word != NoteSet::wordCount && word * NoteSet::bitsPerWord < noteCount; ++word)
+    {
+        const auto remainingWord{ possibleNextNotes.getWord(word) };
+        if (remainingWord == 0)
+            continue;
+
+        const auto rootNoteWord{ rootNoteSet.getWord(word) };
+        uint64_t prunedWord{ 0 };
+
+        const size_t firstNote{ (size_t)word * NoteSet::bitsPerWord };
+        const auto endNote{ std::min(noteCount, firstNote + NoteSet::bitsPerWord) };
+
+        auto note{ firstNote };
+        for (; note + lanes <= endNote; note += lanes)
+        {
+            const auto shift{ note - firstNote };
+            const auto remainingLanes{ (remainingWord >> shift) & 0xF };
+            if (remainingLanes == 0)
+                continue;
+
+            const auto weights{ vld1q_f32(weightsToLastNote + note) };
+            const auto belowCutoff{ vcleq_f32(vmulq_f32(weights, rollingWeights), weightCutoffs) };
+
+            const auto prunedLanes{ ((uint64_t)vaddvq_u32(vandq_u32(belowCutoff, laneBits)) |
+                                     ((rootNoteWord >> shift) & 0xF)) & remainingLanes };
+            prunedWord |= prunedLanes << shift;
+
+            const auto prunedLaneMask{ vceqq_u32(vandq_u32(vdupq_n_u32((uint32_t)prunedLanes), laneBits), laneBits) };
+            prunedWeightSums = vaddq_f32(prunedWeightSums,
+                                         vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(weights), prunedLaneMask)));
+        }
+
+        for (; note != endNote; ++note)
+            if (((remainingWord >> (note - firstNote)) & 1) &&
+                (note == rootNote || weightsToLastNote[note] * rollingWeight <= weightCutoff))
+            {
+                prunedWord |= uint64_t(1) << (note - firstNote);
+                tailPrunedWeightSum += weightsToLastNote[note];
+            }
+
+        partition.notesToTraverse.setWord(word, remainingWord & ~prunedWord);
+    }
+
+    partition.prunedWeightSum = vaddvq_f32(prunedWeightSums) + tailPrunedWeightSum;
+
+    return partition;
+}
+
+static float64x2_t log2Neon(const float64x2_t& values, const int& terms)
+{
+    const auto one{ vdupq_n_f64(1) };
+
+    const auto bits{ vreinterpretq_u64_f64(values) };
+    auto mantissa{ vreinterpretq_f64_u64(vorrq_u64(vandq_u64(bits, vdupq_n_u64(0x000FFFFFFFFFFFFF)),
+                                                   vdupq_n_u64(0x3FF0000000000000))) };
+    auto exponent{ vsubq_f64(vcvtq_f64_u64(vshrq_n_u64(bits, 52)), vdupq_n_f64(1023)) };
+
+    const auto mantissaIsLarge{ vcgtq_f64(mantissa, vdupq_n_f64((double)squareRootOfTwo)) };
+    mantissa = vbslq_f64(mantissaIsLarge, vmulq_f64(mantissa, vdupq_n_f64(0.5)), mantissa);
+    exponent = vaddq_f64(exponent, vreinterpretq_f64_u64(vandq_u64(mantissaIsLarge, vreinterpretq_u64_f64(one))));
+
+    const auto t{ vdivq_f64(vsubq_f64(mantissa, one), vaddq_f64(mantissa, one)) };
+    const auto tSquared{ vmulq_f64(t, t) };
+
+    auto series{ vdupq_n_f64((double)log2SeriesCoefficients[terms - 1]) };
+    for (auto term{ terms - 2 }; term >= 0; --term)
+        series = vfmaq_f64(vdupq_n_f64((double)log2SeriesCoefficients[term]), series, tSquared);
+
+    return vfmaq_f64(exponent, vmulq_f64(t, series), vdupq_n_f64((double)twoOverLn2));
+}
+
+static float32x4_t log2Neon(const float32x4_t& values, const int& terms)
+{
+    const auto one{ vdupq_n_f32(1) };
+
+    const auto bits{ vreinterpretq_u32_f32(values) };
+    auto mantissa{ vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000))) };
+    auto exponent{ vsubq_f32(vcvtq_f32_u32(vshrq_n_u32(bits, 23)), vdupq_n_f32(127)) };
+
+    const auto mantissaIsLarge{ vcgtq_f32(mantissa, vdupq_n_f32((float)squareRootOfTwo)) };
+    mantissa = vbslq_f32(mantissaIsLarge, vmulq_f32(mantissa, vdupq_n_f32(0.5f)), mantissa);
+    exponent = vaddq_f32(exponent, vreinterpretq_f32_u32(vandq_u32(mantissaIsLarge, vreinterpretq_u32_f32(one))));
+
+    const auto t{ vdivq_f32(vsubq_f32(mantissa, one), vaddq_f32(mantissa, one)) };
+    const auto tSquared{ vmulq_f32(t, t) };
+
+    auto series{ vdupq_n_f32((float)log2SeriesCoefficients[terms - 1]) };
+    for (auto term{ terms - 2 }; term >= 0; --term)
+        series = vfmaq_f32(vdupq_n_f32((float)log2SeriesCoefficients[term]), series, tSquared);
+
+    return vfmaq_f32(exponent, vmulq_f32(t, series), vdupq_n_f32((float)twoOverLn2));
+}
+
+static double weightedLog2SumNeon(const double* weights, const double* values, const size_t& count,
+                                  const ApproximationAccuracy& accuracy)
+{
+    const auto terms{ log2SeriesTerms(accuracy) };
+
+    auto sums{ vdupq_n_f64(0) };
+
+    size_t index{ 0 };
+    for (; index + 2 <= count; index += 2)
+        sums = vfmaq_f64(sums, vld1q_f64(weights + index), log2Neon(vld1q_f64(values + index), terms));
+
+    return vaddvq_f64(sums) + weightedLog2SumScalar(weights + index, values + index, count - index, accuracy);
+}
+
+static float weightedLog2SumNeon(const float* weights, const float* values, const size_t& count,
+                                 const ApproximationAccuracy& accuracy)
+{
+    const auto terms{ log2SeriesTerms(accuracy) };
+
+    auto sums{ vdupq_n_f32(0) };
+
+    size_t index{ 0 };
+    for (; index + 4 <= count; index += 4)
+        sums = vfmaq_f32(sums, vld1q_f32(weights + index), log2Neon(vld1q_f32(values + index), terms));
+
+    return vaddvq_f32(sums) + weightedLog2SumScalar(weights + index, values + index, count - index, accuracy);
+}
+#endif
+
+/*
+  True if Real has AVX2 and NEON kernels.
+*/
+template<typename Real>
+static constexpr bool hasVectorKernels{ std::is_same_v<Real, double> || std::is_same_v<Real, float> };
+
+template<typename Real>
+SiblingPartition<Real> SiblingKernels::partitionSiblings(const Real* weightsToLastNote, const size_t& noteCount,
+                                                         const NoteSet& possibleNextNotes, const int& rootNote,
+                                                         const Real& rollingWeight, const Real& weightCutoff)
+{
+    if constexpr (hasVectorKernels<Real>)
+    {
+#if defined(SIBLING_KERNELS_X86)
+        if (cpuSupportsAvx2())
+            return partitionSiblingsAvx2(weightsToLastNote, noteCount, possibleNextNotes, rootNote, rollingWeight,
+                                         weightCutoff);
+#elif defined(SIBLING_KERNELS_NEON)
+        return partitionSiblingsNeon(weightsToLastNote, noteCount, possibleNextNotes, rootNote, rollingWeight,
+                                     weightCutoff);
+#endif
+    }
+
+    return partitionSiblingsScalar(weightsToLastNote, possibleNextNotes, rootNote, rollingWeight, weightCutoff);
+}
+
+template<typename Real>
+Real SiblingKernels::weightedLog2Sum(const Real* weights, const Real* values, const size_t& count,
+                                     const ApproximationAccuracy& accuracy)
+{
+    if constexpr (hasVectorKernels<Real>)
+        if (accuracy != ApproximationAccuracy::exact)
+        {
+#if defined(SIBLING_KERNELS_X86)
+            if (cpuSupportsAvx2())
+                return weightedLog2SumAvx2(weights, values, count, accuracy);
+#elif defined(SIBLING_KERNELS_NEON)
+            return weightedLog2SumNeon(weights, values, count, accuracy);
+#endif
+        }
+
+    return weightedLog2SumScalar(weights, values, count, accuracy);
+}
+
+template<typename Real>
+Real SiblingKernels::approximateLog2(const Real& value, const ApproximationAccuracy& accuracy)
+{
+    if (accuracy == ApproximationAccuracy::exact)
+        return std::log2(value);
+
+    int exponent;
+    auto mantissa{ std::frexp(value, &exponent) };
+
+    //move mantissa from [1/2, 1) into [sqrt(1/2), sqrt(2)]
+    if (mantissa < Real(squareRootOfTwo / 2))
+    {
+        mantissa *= 2;
+        --exponent;
+    }
+
+    const auto t{ (mantissa - 1) / (mantissa + 1) };
+    const auto tSquared{ t * t };
+
+    Real series{ 0 };
+    for (auto term{ log2SeriesTerms(accuracy) - 1 }; term >= 0; --term)
+        series = series * tSquared + Real(log2SeriesCoefficients[term]);
+
+    return Real(exponent) + Real(twoOverLn2) * t * series;
+}
+
+template<typename Real>
+Real SiblingKernels::approximateExp2(const Real& exponent, const ApproximationAccuracy& accuracy)
+{
+    if (accuracy == ApproximationAccuracy::exact)
+        return std::exp2(exponent);
+
+    //exp2(exponent) = 2^wholePart * e^(fraction * ln(2)) with |fraction| <= 1/2
+    const auto wholePart{ std::clamp(std::round(exponent), Real(-65536), Real(65536)) };
+    const auto naturalExponent{ (exponent - wholePart) * Real(ln2) };
+
+    Real series{ 1 };
+    for (auto degree{ exp2TaylorDegree(accuracy) }; degree != 0; --degree)
+        series = 1 + series * naturalExponent / Real(degree);
+
+    return std::ldexp(series, (int)wholePart);
+}
+
+std::string SiblingKernels::instructionSet()
+{
+#if defined(SIBLING_KERNELS_X86)
+    return cpuSupportsAvx2() ? "avx2" : "scalar";
+#elif defined(SIBLING_KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+template SiblingPartition<float> SiblingKernels::partitionSiblings(const float*, const size_t&, const NoteSet&,
+                                                                   const int&, const float&, const float&);
+template SiblingPartition<double> SiblingKernels::partitionSiblings(const double*, const size_t&, const NoteSet&,
+                                                                    const int&, const double&, const double&);
+template SiblingPartition<long double> SiblingKernels::partitionSiblings(const long double*, const size_t&,
+                                                                         const NoteSet&, const int&,
+                                                                         const long double&, const long double&);
+
+template float SiblingKernels::weightedLog2Sum(const float*, const float*, const size_t&, const ApproximationAccuracy&);
+template double SiblingKernels::weightedLog2Sum(const double*, const double*, const size_t&,
+                                                const ApproximationAccuracy&);
+template long double SiblingKernels::weightedLog2Sum(const long double*, const long double*, const size_t&,
+                                                     const ApproximationAccuracy&);
+
+template float SiblingKernels::approximateLog2(const float&, const ApproximationAccuracy&);
+template double SiblingKernels::approximateLog2(const double&, const ApproximationAccuracy&);
+template long double SiblingKernels::approximateLog2(const long double&, const ApproximationAccuracy&);
+
+template float SiblingKernels::approximateExp2(const float&, const ApproximationAccuracy&);
+template double SiblingKernels::approximateExp2(const double&, const ApproximationAccuracy&);
+template long double SiblingKernels::approximateExp2(const long double&, const ApproximationAccuracy&);
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "NoteSet.h"
+#include <string>
+
+/*
+  How closely the approximations of log2 and exp2 in SiblingKernels follow std::log2 and std::exp2. The
+  errors given are the largest relative errors of the approximations themselves, before rounding to the
+  precision of the numeric type they are calculated in.
+*/
+enum class ApproximationAccuracy
+{
+    /*
+      Uses std::log2 and std::exp2.
+    */
+    exact,
+    /*
+      Errors below about 1e-13.
+    */
+    high,
+    /*
+      Errors below about 1e-8.
+    */
+    medium,
+    /*
+      Errors below about 1e-4, which is around 0.1 cents for a log2 sized interval.
+    */
+    low
+};
+
+/*
+  The siblings of a node in a traversal of a scale, split into those which are treated as leaves reaching
+  the root note and those which are traversed.
+*/
+template<typename Real>
+struct SiblingPartition
+{
+    /*
+      The sum of the weights of the intervals to the siblings treated as leaves.
+    */
+    Real prunedWeightSum;
+    NoteSet notesToTraverse;
+};
+
+/*
+  Data parallel kernels for the loop over the siblings of a node in Scale's traversal engines. The float
+  and double kernels use AVX2 or NEON when the CPU running the program supports them, which is checked
+  once at runtime, and scalar code otherwise. The long double kernels are always scalar.
+*/
+namespace SiblingKernels
+{
+    /*
+      Splits possibleNextNotes into siblings treated as leaves, being rootNote and every note whose weight
+      multiplied by rollingWeight is at most weightCutoff, and siblings to be traversed. weightsToLastNote
+      must hold noteCount weights.
+    */
+    template<typename Real>
+    SiblingPartition<Real> partitionSiblings(const Real* weightsToLastNote, const size_t& noteCount,
+                                             const NoteSet& possibleNextNotes, const int& rootNote,
+                                             const Real& rollingWeight, const Real& weightCutoff);
+
+    /*
+      Returns the sum of weights[i] * log2(values[i]) for i in [0, count).
+    */
+    template<typename Real>
+    Real weightedLog2Sum(const Real* weights, const Real* values, const size_t& count,
+                         const ApproximationAccuracy& accuracy);
+
+    /*
+      Returns an approximation of log2(value) for value > 0.
+    */
+    template<typename Real>
+    Real approximateLog2(const Real& value, const ApproximationAccuracy& accuracy);
+
+    /*
+      Returns an approximation of exp2(exponent).
+    */
+    template<typename Real>
+    Real approximateExp2(const Real& exponent, const ApproximationAccuracy& accuracy);
+
+    /*
+      Returns the name of the instruction set the float and double kernels use on this CPU: "avx2",
+      "neon" or "scalar".
+    */
+    std::string instructionSet();
+}
\ No newline at end of file
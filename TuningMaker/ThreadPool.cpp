@@ -0,0 +1,187 @@
+#include "ThreadPool.h"
+
+static thread_local const ThreadPool* poolOfCallingThread{ nullptr };
+static thread_local size_t queueIndexOfCallingThread{ 0 };
+
+ThreadPool::ThreadPool(const unsigned& threadCount)
+{
+    queues.reserve(threadCount + 1);
+    for (auto queue{ 0u }; queue != threadCount + 1; ++queue)
+        queues.push_back(std::make_unique<TaskQueue>());
+
+    workers.reserve(threadCount);
+    for (auto worker{ 0u }; worker != threadCount; ++worker)
+        workers.emplace_back([this, worker]() { workerLoop(worker); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+
+    stateChanged.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+size_t ThreadPool::size() const
+{
+    return workers.size();
+}
+
+void ThreadPool::submit(Task task)
+{
+    auto& queue{ *queues[queueOfCallingThread()] };
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    ++queuedTasks;
+    notifyStateChanged();
+}
+
+bool ThreadPool::tryRunTask(const size_t& ownQueue)
+{
+    Task task;
+    auto foundTask{ false };
+
+    for (auto offset{ 0u }; offset != queues.size() && !foundTask; ++offset)
+    {
+        const auto queueIndex{ (ownQueue + offset) % queues.size() };
+        auto& queue{ *queues[queueIndex] };
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        if (offset == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        foundTask = true;
+    }
+
+    if (!foundTask)
+        return false;
+
+    --queuedTasks;
+
+    std::exception_ptr exception;
+    try
+    {
+        task.function();
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    task.group->finishTask(exception);
+
+    return true;
+}
+
+void ThreadPool::notifyStateChanged()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+    }
+
+    stateChanged.notify_all();
+}
+
+void ThreadPool::workerLoop(const size_t& workerIndex)
+{
+    poolOfCallingThread = this;
+    queueIndexOfCallingThread = workerIndex;
+
+    while (true)
+    {
+        if (tryRunTask(workerIndex))
+            continue;
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        stateChanged.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+
+        if (stopping && queuedTasks == 0)
+            return;
+    }
+}
+
+size_t ThreadPool::queueOfCallingThread() const
+{
+    return poolOfCallingThread == this ? queueIndexOfCallingThread : queues.size() - 1;
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : threadPool(pool)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    ++pendingTasks;
+    threadPool.submit({ std::move(task), this });
+}
+
+void TaskGroup::wait()
+{
+    const auto ownQueue{ threadPool.queueOfCallingThread() };
+
+    while (pendingTasks > 0)
+    {
+        if (threadPool.tryRunTask(ownQueue))
+            continue;
+
+        std::unique_lock<std::mutex> lock(threadPool.stateMutex);
+        threadPool.stateChanged.wait(lock, [this]() { return pendingTasks == 0 || threadPool.queuedTasks > 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(exceptionMutex);
+    if (firstException)
+    {
+        auto exception{ firstException };
+        firstException = nullptr;
+
+        std::rethrow_exception(exception);
+    }
+}
+
+void TaskGroup::finishTask(std::exception_ptr exception)
+{
+    if (exception)
+    {
+        std::lock_guard<std::mutex> lock(exceptionMutex);
+        if (!firstException)
+            firstException = exception;
+    }
+
+    //the group may be destroyed as soon as pendingTasks reaches 0, so the pool is read beforehand
+    auto& pool{ threadPool };
+
+    if (--pendingTasks == 0)
+        pool.notifyStateChanged();
+}
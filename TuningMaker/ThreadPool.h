@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+/*
+  A reusable set of worker threads which execute tasks submitted through a TaskGroup. Every worker owns
+  a queue of tasks: it runs the newest task in its own queue first and, once that queue is empty, steals
+  the oldest task from the queue of another worker. Threads which wait on a TaskGroup run queued tasks
+  while they wait, so a task may itself submit tasks to the pool and wait on them.
+*/
+class ThreadPool
+{
+public:
+    /*
+      Constructs a pool of threadCount worker threads. A pool of 0 threads is valid, in which case all
+      tasks are run by the threads which wait on them.
+    */
+    ThreadPool(const unsigned& threadCount = std::max(1u, std::thread::hardware_concurrency()));
+
+    /*
+      Finishes all queued tasks and joins the worker threads.
+    */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /*
+      Returns the number of worker threads in the pool.
+    */
+    size_t size() const;
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /*
+      One queue per worker, followed by one queue for tasks submitted by threads outside of the pool.
+    */
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<size_t> queuedTasks{ 0 };
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    bool stopping{ false };
+
+    /*
+      Pushes task to the queue of the calling worker, or to the shared queue if the calling thread is not
+      a worker of this pool, and wakes a sleeping thread.
+    */
+    void submit(Task task);
+
+    /*
+      Takes a task from the queue at ownQueue (newest first) or steals one from any other queue (oldest
+      first), and runs it. Returns false if every queue was empty.
+    */
+    bool tryRunTask(const size_t& ownQueue);
+
+    /*
+      Wakes every thread which is sleeping on stateChanged.
+    */
+    void notifyStateChanged();
+
+    /*
+      The loop run by each worker thread until the pool is destroyed.
+    */
+    void workerLoop(const size_t& workerIndex);
+
+    /*
+      Returns the index of the queue owned by the calling thread, or the index of the shared queue if the
+      calling thread is not a worker of this pool.
+    */
+    size_t queueOfCallingThread() const;
+};
+
+/*
+  A set of tasks run on a ThreadPool which can be waited on together. The first exception thrown by a
+  task is rethrown by wait().
+*/
+class TaskGroup
+{
+public:
+    /*
+      Constructs an empty group whose tasks will run on pool.
+    */
+    TaskGroup(ThreadPool& pool);
+
+    /*
+      Waits for all tasks in the group to finish.
+    */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /*
+      Queues task to run on the pool.
+    */
+    void run(std::function<void()> task);
+
+    /*
+      Runs queued tasks until every task in the group has finished, then rethrows the first exception
+      thrown by a task in the group, if any.
+    */
+    void wait();
+
+private:
+    friend class ThreadPool;
+
+    ThreadPool& threadPool;
+    std::atomic<size_t> pendingTasks{ 0 };
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+
+    /*
+      Called by the pool after one of this group's tasks has run.
+    */
+    void finishTask(std::exception_ptr exception);
+};
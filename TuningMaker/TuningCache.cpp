@@ -0,0 +1,408 @@
+#include "TuningCache.h"
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char indexMagic[8]{ 'T', 'M', 'C', 'A', 'C', 'H', 'E', '1' };
+static constexpr uint64_t indexSlotCount{ 4096 };
+/*
+  The index is kept at most three quarters full so that probes stay short.
+*/
+static constexpr uint64_t maxEntryCount{ indexSlotCount / 4 * 3 };
+
+struct TuningCache::IndexHeader
+{
+    char magic[8];
+    /*
+      The size of long double in the process which created the cache. Entries store long doubles as they
+      are in memory, so a cache can't be shared between processes for which it differs.
+    */
+    uint64_t longDoubleSize;
+    uint64_t entryCount;
+    uint64_t totalBytes;
+    /*
+      Incremented whenever an entry is used, giving the order in which entries were last used.
+    */
+    uint64_t clock;
+    uint64_t reserved[3];
+};
+
+struct TuningCache::IndexSlot
+{
+    /*
+      The hash of the entry's key, or 0 if the slot is empty.
+    */
+    uint64_t hash;
+    uint64_t bytes;
+    uint64_t lastUsed;
+};
+
+/*
+  The size of the index file: a 64 byte header followed by indexSlotCount slots of 24 bytes.
+*/
+static constexpr size_t indexBytes{ 64 + indexSlotCount * 24 };
+
+class TuningCache::FileLock
+{
+public:
+    FileLock(const intptr_t& f)
+        : file(f)
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        LockFileEx((HANDLE)file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+        while (flock((int)file, LOCK_EX) != 0 && errno == EINTR);
+#endif
+    }
+
+    ~FileLock()
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        UnlockFileEx((HANDLE)file, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+        flock((int)file, LOCK_UN);
+#endif
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    intptr_t file;
+};
+
+TuningCache::TuningCache(const std::filesystem::path& d, const uint64_t& m)
+    : directory(d)
+    , maxBytes(m)
+{
+    static_assert(sizeof(IndexHeader) == 64 && sizeof(IndexSlot) == 24);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    if (!openIndex() && index != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(index);
+#else
+        munmap(index, indexBytes);
+#endif
+        index = nullptr;
+    }
+}
+
+TuningCache::~TuningCache()
+{
+#ifdef _WIN32
+    if (index != nullptr)
+        UnmapViewOfFile(index);
+    if (indexMapping != -1 && indexMapping != 0)
+        CloseHandle((HANDLE)indexMapping);
+    if (indexFile != -1)
+        CloseHandle((HANDLE)indexFile);
+    if (lockFile != -1)
+        CloseHandle((HANDLE)lockFile);
+#else
+    if (index != nullptr)
+        munmap(index, indexBytes);
+    if (indexFile != -1)
+        close((int)indexFile);
+    if (lockFile != -1)
+        close((int)lockFile);
+#endif
+}
+
+std::optional<std::vector<std::vector<long double>>> TuningCache::find(const std::string& key)
+{
+    if (!isOpen())
+        return std::nullopt;
+
+    const auto hash{ hashKey(key) };
+
+    std::lock_guard<std::mutex> threadLock(mutex);
+    FileLock processLock(lockFile);
+
+    auto* slot{ findSlot(hash) };
+
+    if (slot == nullptr)
+        return std::nullopt;
+
+    std::ifstream entry(entryPath(hash), std::ios::binary);
+
+    uint64_t keyLength{ 0 }, noteCount{ 0 };
+    entry.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+
+    //a different key with the same hash is a miss, and is replaced by the next insert
+    if (!entry || keyLength != key.size())
+        return std::nullopt;
+
+    std::string entryKey(keyLength, '\0');
+    entry.read(entryKey.data(), keyLength);
+    entry.read(reinterpret_cast<char*>(&noteCount), sizeof(noteCount));
+
+    if (!entry || entryKey != key || noteCount > 1024)
+        return std::nullopt;
+
+    std::vector<std::vector<long double>> tunings(noteCount, std::vector<long double>(noteCount));
+
+    for (auto& rootNoteTunings : tunings)
+        entry.read(reinterpret_cast<char*>(rootNoteTunings.data()), noteCount * sizeof(long double));
+
+    if (!entry)
+    {
+        removeEntry(*slot);
+
+        return std::nullopt;
+    }
+
+    slot->lastUsed = ++index->clock;
+
+    return tunings;
+}
+
+void TuningCache::insert(const std::string& key, const std::vector<std::vector<long double>>& tunings)
+{
+    if (!isOpen())
+        return;
+
+    const auto hash{ hashKey(key) };
+    const uint64_t noteCount{ tunings.size() };
+    const auto bytes{ sizeof(uint64_t) * 2 + key.size() + noteCount * noteCount * sizeof(long double) };
+
+    if (bytes > maxBytes)
+        return;
+
+    //write the entry before locking, under a name no other writer can be using
+    std::ostringstream temporaryName;
+    temporaryName << std::hex << std::setw(16) << std::setfill('0') << hash << "."
+                  << std::random_device()() << ".tmp";
+    const auto temporaryPath{ directory / temporaryName.str() };
+
+    {
+        std::ofstream entry(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        const uint64_t keyLength{ key.size() };
+        entry.write(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+        entry.write(key.data(), keyLength);
+        entry.write(reinterpret_cast<const char*>(&noteCount), sizeof(noteCount));
+
+        for (const auto& rootNoteTunings : tunings)
+            entry.write(reinterpret_cast<const char*>(rootNoteTunings.data()), noteCount * sizeof(long double));
+
+        if (!entry)
+        {
+            entry.close();
+
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> threadLock(mutex);
+    FileLock processLock(lockFile);
+
+    if (auto* slot{ findSlot(hash) }; slot != nullptr)
+        removeEntry(*slot);
+
+    while (index->entryCount != 0 && (index->entryCount >= maxEntryCount || index->totalBytes + bytes > maxBytes))
+        evictLeastRecentlyUsedEntry();
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, entryPath(hash), error);
+
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+
+        return;
+    }
+
+    auto* slots{ reinterpret_cast<IndexSlot*>(index + 1) };
+    auto slotIndex{ hash % indexSlotCount };
+
+    while (slots[slotIndex].hash != 0)
+        slotIndex = (slotIndex + 1) % indexSlotCount;
+
+    slots[slotIndex] = { hash, bytes, ++index->clock };
+    ++index->entryCount;
+    index->totalBytes += bytes;
+}
+
+uint64_t TuningCache::getSizeInBytes() const
+{
+    return isOpen() ? index->totalBytes : 0;
+}
+
+bool TuningCache::openIndex()
+{
+    const auto lockPath{ directory / "lock" };
+    const auto indexPath{ directory / "index" };
+
+#ifdef _WIN32
+    lockFile = (intptr_t)CreateFileW(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr);
+    if ((HANDLE)lockFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    FileLock processLock(lockFile);
+
+    indexFile = (intptr_t)CreateFileW(indexPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+    if ((HANDLE)indexFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx((HANDLE)indexFile, &fileSize))
+        return false;
+
+    const auto isNewIndex{ fileSize.QuadPart == 0 };
+
+    if (!isNewIndex && fileSize.QuadPart != indexBytes)
+        return false;
+
+    indexMapping = (intptr_t)CreateFileMappingW((HANDLE)indexFile, nullptr, PAGE_READWRITE, 0, (DWORD)indexBytes,
+                                                nullptr);
+    if (indexMapping == 0)
+        return false;
+
+    index = static_cast<IndexHeader*>(MapViewOfFile((HANDLE)indexMapping, FILE_MAP_ALL_ACCESS, 0, 0, indexBytes));
+#else
+    lockFile = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFile == -1)
+        return false;
+
+    FileLock processLock(lockFile);
+
+    indexFile = open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (indexFile == -1)
+        return false;
+
+    struct stat fileStatus;
+    if (fstat((int)indexFile, &fileStatus) != 0)
+        return false;
+
+    const auto isNewIndex{ fileStatus.st_size == 0 };
+
+    if (!isNewIndex && fileStatus.st_size != indexBytes)
+        return false;
+
+    //the file is zero filled, so a new index starts empty
+    if (isNewIndex && ftruncate((int)indexFile, indexBytes) != 0)
+        return false;
+
+    auto* mapping{ mmap(nullptr, indexBytes, PROT_READ | PROT_WRITE, MAP_SHARED, (int)indexFile, 0) };
+    if (mapping == MAP_FAILED)
+        return false;
+
+    index = static_cast<IndexHeader*>(mapping);
+#endif
+
+    if (index == nullptr)
+        return false;
+
+    if (isNewIndex)
+    {
+        std::memcpy(index->magic, indexMagic, sizeof(indexMagic));
+        index->longDoubleSize = sizeof(long double);
+    }
+
+    return std::memcmp(index->magic, indexMagic, sizeof(indexMagic)) == 0
+        && index->longDoubleSize == sizeof(long double);
+}
+
+TuningCache::IndexSlot* TuningCache::findSlot(const uint64_t& hash) const
+{
+    auto* slots{ reinterpret_cast<IndexSlot*>(index + 1) };
+
+    for (auto slotIndex{ hash % indexSlotCount }; slots[slotIndex].hash != 0; slotIndex = (slotIndex + 1) % indexSlotCount)
+        if (slots[slotIndex].hash == hash)
+            return &slots[slotIndex];
+
+    return nullptr;
+}
+
+void TuningCache::removeEntry(IndexSlot& slot)
+{
+    std::error_code error;
+    std::filesystem::remove(entryPath(slot.hash), error);
+
+    --index->entryCount;
+    index->totalBytes -= slot.bytes;
+
+    //shift later slots of the same probe sequence back, so that no probe stops early at the emptied slot
+    auto* slots{ reinterpret_cast<IndexSlot*>(index + 1) };
+    auto emptySlotIndex{ (uint64_t)(&slot - slots) };
+    slots[emptySlotIndex].hash = 0;
+
+    for (auto slotIndex{ (emptySlotIndex + 1) % indexSlotCount }; slots[slotIndex].hash != 0;
+         slotIndex = (slotIndex + 1) % indexSlotCount)
+    {
+        const auto homeSlotIndex{ slots[slotIndex].hash % indexSlotCount };
+
+        //the distance probed from each slot's home to reach it
+        const auto distanceToEmptySlot{ (emptySlotIndex - homeSlotIndex + indexSlotCount) % indexSlotCount };
+        const auto distanceToSlot{ (slotIndex - homeSlotIndex + indexSlotCount) % indexSlotCount };
+
+        if (distanceToEmptySlot < distanceToSlot)
+        {
+            slots[emptySlotIndex] = slots[slotIndex];
+            slots[slotIndex].hash = 0;
+            emptySlotIndex = slotIndex;
+        }
+    }
+}
+
+void TuningCache::evictLeastRecentlyUsedEntry()
+{
+    auto* slots{ reinterpret_cast<IndexSlot*>(index + 1) };
+    IndexSlot* leastRecentlyUsed{ nullptr };
+
+    for (uint64_t slotIndex{ 0 }; slotIndex != indexSlotCount; ++slotIndex)
+        if (slots[slotIndex].hash != 0 && (leastRecentlyUsed == nullptr
+                                           || slots[slotIndex].lastUsed < leastRecentlyUsed->lastUsed))
+            leastRecentlyUsed = &slots[slotIndex];
+
+    if (leastRecentlyUsed != nullptr)
+        removeEntry(*leastRecentlyUsed);
+}
+
+std::filesystem::path TuningCache::entryPath(const uint64_t& hash) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".tunings";
+
+    return directory / name.str();
+}
+
+uint64_t TuningCache::hashKey(const std::string& key)
+{
+    uint64_t hash{ 0xCBF29CE484222325 };
+
+    for (const auto& character : key)
+    {
+        hash ^= (unsigned char)character;
+        hash *= 0x100000001B3;
+    }
+
+    return hash != 0 ? hash : 1;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+  A cache of populated tunings kept in a directory on disk, so that a scale tuned once is never tuned again
+  by any process which opens the same directory. Each entry is addressed by a hash of a key which describes
+  everything the populated tunings depend on (see Scale::tuneScale()), and stores the tuning of every note
+  for every root note, so that one entry answers any trueRootNote.
+
+  The directory holds one file per entry and an index of fixed size, which is memory-mapped so that a
+  lookup reads the index without any system calls. Access from several processes, and several threads, is
+  serialised with a lock file, and entries are written to a temporary file and renamed into place so that a
+  reader never sees half an entry. Once the entries together take more than the size cap, the least
+  recently used are deleted. If the directory can't be opened the cache is empty and inserts do nothing.
+*/
+class TuningCache
+{
+public:
+    /*
+      Opens or creates the cache in directory, holding at most maxBytes of entries.
+    */
+    TuningCache(const std::filesystem::path& directory, const uint64_t& maxBytes = uint64_t(1) << 30);
+
+    /*
+      Unmaps the index.
+    */
+    ~TuningCache();
+
+    TuningCache(const TuningCache&) = delete;
+    TuningCache& operator=(const TuningCache&) = delete;
+
+    /*
+      Returns true if the cache directory and index could be opened.
+    */
+    inline bool isOpen() const
+    {
+        return index != nullptr;
+    }
+
+    /*
+      Returns the tunings stored for key, where tunings[rootNote][note] is the tuning of note for rootNote,
+      or std::nullopt if there are none.
+    */
+    std::optional<std::vector<std::vector<long double>>> find(const std::string& key);
+
+    /*
+      Stores tunings for key, replacing any tunings already stored for it, then deletes the least recently
+      used entries until the cache is within its size cap.
+    */
+    void insert(const std::string& key, const std::vector<std::vector<long double>>& tunings);
+
+    /*
+      Returns the total size in bytes of the entries in the cache.
+    */
+    uint64_t getSizeInBytes() const;
+
+private:
+    /*
+      The layout of the memory-mapped index: a header followed by an open addressed hash table of entries.
+    */
+    struct IndexHeader;
+    struct IndexSlot;
+
+    /*
+      Holds the lock file exclusively for as long as it exists.
+    */
+    class FileLock;
+
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+
+    /*
+      Serialises access from threads of this process, which the lock file does not.
+    */
+    std::mutex mutex;
+
+    /*
+      The lock file and index file, as a file descriptor or a Windows HANDLE, and the mapping of the index.
+    */
+    intptr_t lockFile{ -1 };
+    intptr_t indexFile{ -1 };
+    intptr_t indexMapping{ -1 };
+    IndexHeader* index{ nullptr };
+
+    /*
+      Maps the index, creating and initialising it if it doesn't exist. Returns false if it can't.
+    */
+    bool openIndex();
+
+    /*
+      Returns the slot holding hash, or nullptr.
+    */
+    IndexSlot* findSlot(const uint64_t& hash) const;
+
+    /*
+      Removes the entry in slot and deletes its file.
+    */
+    void removeEntry(IndexSlot& slot);
+
+    /*
+      Removes the entry which was used least recently.
+    */
+    void evictLeastRecentlyUsedEntry();
+
+    /*
+      Returns the path of the file of the entry with hash.
+    */
+    std::filesystem::path entryPath(const uint64_t& hash) const;
+
+    /*
+      Returns the 64 bit FNV-1a hash of key, which is never 0.
+    */
+    static uint64_t hashKey(const std::string& key);
+};
\ No newline at end of file
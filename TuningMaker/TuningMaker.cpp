@@ -1,7 +1,6 @@
 #include "PitchSpace.h"
 #include <fstream>
-
-static constexpr size_t maxMidiNotes{ 128 };
+#include <sstream>
 
 template<typename Relation>
 static void addCustomScaleToPitchSpace(PitchSpace<Relation>& pitchSpace, const std::string& scaleName)
@@ -42,7 +41,7 @@ static void addCustomDecimalPitchSpace(const std::string& pitchSpaceName)
     }
 
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    PitchSpaces::decimal.insert({ pitchSpaceName, relationsTable });
+    PitchSpaces::decimal().insert({ pitchSpaceName, relationsTable });
 }
 
 static void addCustomFractionalPitchSpace(const std::string& pitchSpaceName)
@@ -73,12 +72,12 @@ static void addCustomFractionalPitchSpace(const std::string& pitchSpaceName)
     }
 
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    PitchSpaces::fractional.insert({ pitchSpaceName, relationsTable });
+    PitchSpaces::fractional().insert({ pitchSpaceName, relationsTable });
 }
 
 static void printTuning(const std::vector<double>& tuning)
 {
-    std::cout << std::endl << "As linear factors: " << std::endl;
+    std::cout << "\nAs linear factors: \n";
 
     for (auto note{ 0 }; note != tuning.size(); ++note)
     {
@@ -90,7 +89,7 @@ static void printTuning(const std::vector<double>& tuning)
             std::cout << '\n' << std::setprecision(4) << factor;
     }
 
-	std::cout << std::endl << std::endl << "As cents: " << std::endl << std::endl;
+	std::cout << "\n\nAs cents: \n\n";
 
     for (auto note{ 0 }; note != tuning.size(); ++note)
     {
@@ -103,11 +102,672 @@ static void printTuning(const std::vector<double>& tuning)
 
         std::cout << '\n';
     }
+
+    std::cout << std::flush;
+}
+
+/*
+  A job read from a job file in batch mode: one tuning of a scale in a named pitch space.
+*/
+struct CommandLineJob
+{
+    std::string id;
+    std::string pitchSpaceName;
+    bool isFractional{ true };
+    BatchTuningJob tuningJob;
+    /*
+      If not empty, the job tunes every MIDI key with PitchSpace::tuneKeyboard() instead, and writes the
+      tuning to this path with KeyboardTuning::writeFiles().
+    */
+    std::string keyboardPath;
+    KeyboardTuningJob keyboardJob;
+    /*
+      Empty if the job was read successfully, otherwise why it couldn't be.
+    */
+    std::string error;
+};
+
+/*
+  Reads the whole of text into value, returning false if text isn't a value of type T.
+*/
+template<typename T>
+static bool readValue(const std::string& text, T& value)
+{
+    std::istringstream stream(text);
+    stream >> value;
+
+    return !stream.fail() && stream.eof();
+}
+
+/*
+  Reads a job from a line of the form "space=12edo scale=ionian range=12 root=0 curve=1 cutoff=0.0001
+  dummies=n id=name", in which only space, scale, and range are required. A keyboard job, which has the
+  fields "keyboard=path periods=2 key=60 frequency=261.6256" of which only keyboard is required, needs no
+  range, and its root is the degree of the scale played by key.
+*/
+static CommandLineJob parseJob(const std::string& line, const std::string& defaultId)
+{
+    CommandLineJob job;
+    job.id = defaultId;
+    job.tuningJob.range = 0;
+
+    std::istringstream fields(line);
+
+    for (std::string field; fields >> field;)
+    {
+        const auto separatorPosition{ field.find('=') };
+        const auto key{ field.substr(0, separatorPosition) };
+        const auto value{ separatorPosition == std::string::npos ? std::string() : field.substr(separatorPosition + 1) };
+
+        auto isValid{ !value.empty() };
+
+        if (key == "id")
+            job.id = value;
+        else if (key == "space")
+            job.pitchSpaceName = value;
+        else if (key == "scale")
+            job.tuningJob.signiatureName = value;
+        else if (key == "range")
+            isValid = isValid && readValue(value, job.tuningJob.range);
+        else if (key == "root")
+            isValid = isValid && readValue(value, job.tuningJob.trueRootNote);
+        else if (key == "curve")
+            isValid = isValid && readValue(value, job.tuningJob.entropyCurve);
+        else if (key == "cutoff")
+            isValid = isValid && readValue(value, job.tuningJob.weightCutoff);
+        else if (key == "keyboard")
+            job.keyboardPath = value;
+        else if (key == "periods")
+            isValid = isValid && readValue(value, job.keyboardJob.periods);
+        else if (key == "key")
+            isValid = isValid && readValue(value, job.keyboardJob.rootKey);
+        else if (key == "frequency")
+            isValid = isValid && readValue(value, job.keyboardJob.rootFrequency);
+        else if (key == "dummies")
+        {
+            isValid = value == "y" || value == "n";
+            job.tuningJob.withDummyNotes = value == "y";
+        }
+        else
+            isValid = false;
+
+        if (!isValid && job.error.empty())
+            job.error = "invalid field '" + field + "'";
+    }
+
+    if (!job.error.empty())
+        return job;
+
+    const auto fractionalSpace{ PitchSpaces::fractional().find(job.pitchSpaceName) };
+    const auto decimalSpace{ PitchSpaces::decimal().find(job.pitchSpaceName) };
+    job.isFractional = fractionalSpace != PitchSpaces::fractional().end();
+
+    if (!job.isFractional && decimalSpace == PitchSpaces::decimal().end())
+    {
+        job.error = "unknown pitch space '" + job.pitchSpaceName + "'";
+
+        return job;
+    }
+
+    const auto signiature{ job.isFractional ? fractionalSpace->second.getSigniature(job.tuningJob.signiatureName)
+                                            : decimalSpace->second.getSigniature(job.tuningJob.signiatureName) };
+
+    if (!job.keyboardPath.empty())
+    {
+        job.keyboardJob.signiatureName = job.tuningJob.signiatureName;
+        job.keyboardJob.entropyCurve = job.tuningJob.entropyCurve;
+        job.keyboardJob.weightCutoff = job.tuningJob.weightCutoff;
+        job.keyboardJob.rootDegree = job.tuningJob.trueRootNote;
+        job.keyboardJob.withDummyNotes = job.tuningJob.withDummyNotes;
+        //the range tuned by PitchSpace::tuneKeyboard()
+        job.tuningJob.range = signiature.has_value() ? job.keyboardJob.periods * signiature->size() + 1 : 0;
+    }
+
+    if (!signiature.has_value())
+        job.error = "unknown scale '" + job.tuningJob.signiatureName + "'";
+    else if (!job.keyboardPath.empty() && (job.keyboardJob.periods < 1 || job.tuningJob.range > maxMidiNotes))
+        job.error = "periods must be at least 1 and tune at most " + std::to_string(maxMidiNotes) + " notes";
+    else if (!job.keyboardPath.empty() && (job.keyboardJob.rootKey < 0 || job.keyboardJob.rootKey >= maxMidiNotes))
+        job.error = "key must be between 0 and " + std::to_string(maxMidiNotes - 1);
+    else if (!job.keyboardPath.empty() && !KeyboardTuning::isFrequencyInMidiRange(job.keyboardJob.rootFrequency))
+        job.error = "frequency must be one MIDI can tune, from MIDI key 0 to just short of a semitone above key 127";
+    else if (!job.keyboardPath.empty() && job.tuningJob.trueRootNote >= signiature->size())
+        job.error = "root must be a degree of the scale";
+    else if (job.tuningJob.range < 2 || job.tuningJob.range > maxMidiNotes)
+        job.error = "range must be between 2 and " + std::to_string(maxMidiNotes);
+    else if (job.tuningJob.trueRootNote < 0 || job.tuningJob.trueRootNote >= job.tuningJob.range)
+        job.error = "root must be between 0 and range - 1";
+    else if (job.tuningJob.weightCutoff < 0 || job.tuningJob.weightCutoff > 1)
+        job.error = "cutoff must be between 0 and 1";
+
+    return job;
+}
+
+/*
+  Returns text as a quoted JSON string.
+*/
+static std::string toJsonString(const std::string& text)
+{
+    std::ostringstream json;
+    json << '"';
+
+    for (const auto& character : text)
+    {
+        if (character == '"' || character == '\\')
+            json << '\\' << character;
+        else if ((unsigned char)character < 0x20)
+            json << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)character << std::dec;
+        else
+            json << character;
+    }
+
+    json << '"';
+
+    return json.str();
+}
+
+/*
+  Formats the result of job as one line of JSON. Dummy notes, and keys MIDI can't tune, are null.
+*/
+static std::string formatJobResult(const CommandLineJob& job, const std::optional<std::vector<double>>& tuning)
+{
+    std::ostringstream line;
+    line << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    line << "{\"id\":" << toJsonString(job.id);
+
+    if (!job.error.empty() || !tuning.has_value())
+    {
+        line << ",\"status\":\"error\",\"error\":" << toJsonString(job.error.empty() ? "tuning failed" : job.error) << "}\n";
+
+        return line.str();
+    }
+
+    line << ",\"status\":\"ok\",\"space\":" << toJsonString(job.pitchSpaceName)
+         << ",\"scale\":" << toJsonString(job.tuningJob.signiatureName);
+
+    if (job.keyboardPath.empty())
+        line << ",\"range\":" << job.tuningJob.range;
+    else
+        line << ",\"keyboard\":" << toJsonString(job.keyboardPath) << ",\"key\":" << job.keyboardJob.rootKey;
+
+    line << ",\"root\":" << job.tuningJob.trueRootNote;
+
+    for (const auto& [name, inCents] : { std::make_pair("tuning", false), std::make_pair("cents", true) })
+    {
+        line << ",\"" << name << "\":[";
+
+        for (auto note{ 0 }; note != tuning->size(); ++note)
+        {
+            const auto& factor{ tuning.value()[note] };
+
+            line << (note != 0 ? "," : "");
+
+            if (std::isnan(factor))
+                line << "null";
+            else
+                line << (inCents ? centsFromRatio(factor) : factor);
+        }
+
+        line << "]";
+    }
+
+    line << "}\n";
+
+    return line.str();
+}
+
+/*
+  Writes the results of jobs in the order of the jobs, as soon as every earlier result has been written.
+  Results which become writable together are written and flushed at once, rather than line by line.
+*/
+class OrderedResultWriter
+{
+public:
+    OrderedResultWriter(std::ostream& o, const size_t& resultCount)
+        : output(o)
+        , results(resultCount)
+    {
+    }
+
+    void write(const size_t& index, std::string result)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        results[index] = std::move(result);
+
+        std::string buffer;
+
+        for (; nextIndex != results.size() && results[nextIndex].has_value(); ++nextIndex)
+        {
+            buffer += results[nextIndex].value();
+            results[nextIndex].reset();
+        }
+
+        if (!buffer.empty())
+            output.write(buffer.data(), buffer.size()).flush();
+    }
+
+private:
+    std::ostream& output;
+    std::mutex mutex;
+    std::vector<std::optional<std::string>> results;
+    size_t nextIndex{ 0 };
+};
+
+/*
+  Tunes jobs, all in pitchSpace, as one batch, and passes the result of each to writer.
+*/
+template<typename Relation>
+static void runJobsInPitchSpace(const PitchSpace<Relation>& pitchSpace, const std::vector<CommandLineJob>& jobs,
+                                const std::vector<size_t>& jobIndecies, const TuningSettings& settings,
+                                OrderedResultWriter& writer, std::atomic<size_t>& failedJobCount)
+{
+    std::vector<BatchTuningJob> tuningJobs;
+    for (const auto& jobIndex : jobIndecies)
+        tuningJobs.push_back(jobs[jobIndex].tuningJob);
+
+    pitchSpace.tuneBatch(tuningJobs, settings, [&](const size_t& batchIndex, const std::optional<std::vector<double>>& tuning)
+        {
+            const auto jobIndex{ jobIndecies[batchIndex] };
+
+            if (!tuning.has_value())
+                ++failedJobCount;
+
+            writer.write(jobIndex, formatJobResult(jobs[jobIndex], tuning));
+        });
+}
+
+/*
+  Tunes the keyboard job at jobIndex, which is in pitchSpace, writes its files, and passes its result to writer.
+*/
+template<typename Relation>
+static void runKeyboardJob(const PitchSpace<Relation>& pitchSpace, const std::vector<CommandLineJob>& jobs,
+                           const size_t& jobIndex, const TuningSettings& settings, OrderedResultWriter& writer,
+                           std::atomic<size_t>& failedJobCount)
+{
+    auto job{ jobs[jobIndex] };
+    std::optional<std::vector<double>> ratios;
+
+    if (const auto tuning{ pitchSpace.tuneKeyboard(job.keyboardJob, settings) }; !tuning.has_value())
+        job.error = "tuning failed";
+    else if (!KeyboardTuning::writeFiles(tuning.value(), job.keyboardPath))
+        job.error = "can't write tuning files to " + job.keyboardPath;
+    else
+        ratios.emplace(tuning->ratios.begin(), tuning->ratios.end());
+
+    if (!ratios.has_value())
+        ++failedJobCount;
+
+    writer.write(jobIndex, formatJobResult(job, ratios));
+}
+
+static void printBatchUsage()
+{
+    std::cerr << "Usage: TuningMaker --batch <job file or - for stdin> [--output <file>] [--threads <n>] [--cache <directory>]\n"
+              << "                   [--checkpoint <directory>]\n"
+              << "Each line of the job file is a job of the form\n"
+              << "    space=12edo scale=ionian range=12 root=0 curve=1 cutoff=0.0001 dummies=n id=name\n"
+              << "in which only space, scale, and range are required. Blank lines and lines starting with # are skipped.\n"
+              << "A job with the fields\n"
+              << "    keyboard=path periods=2 key=60 frequency=261.6256\n"
+              << "instead tunes periods periods of the scale, extends the tuning to every MIDI key with root played by key,\n"
+              << "and writes it to path.scl, path.kbm, path.tun, and path.syx. Only keyboard is required, and range is not.\n"
+              << "Every job is tuned concurrently and its result written as a line of JSON, in the order of the jobs.\n"
+              << "With --checkpoint, every job but a keyboard job is checkpointed to <directory>/<id>.checkpoint as it is\n"
+              << "tuned, and running the same job file again carries on from the checkpoints. A job whose checkpoint was\n"
+              << "made for a different scale or cutoff fails.\n"
+              << "Exits with 0 if every job succeeded, 1 if any failed, and 2 if the arguments or job file are invalid.\n"
+              << std::flush;
+}
+
+/*
+  Runs the jobs in a job file without any prompts, for use from scripts.
+*/
+static int runBatchMode(const int& argc, char* argv[])
+{
+    std::string jobPath, outputPath, cachePath, checkpointPath;
+    auto threadCount{ std::max(1u, std::thread::hardware_concurrency()) };
+
+    for (auto argument{ 1 }; argument < argc; ++argument)
+    {
+        const std::string option{ argv[argument] };
+
+        if (argument + 1 == argc || (option == "--threads" && !readValue(argv[argument + 1], threadCount)))
+        {
+            printBatchUsage();
+
+            return 2;
+        }
+
+        const std::string value{ argv[++argument] };
+
+        if (option == "--batch")
+            jobPath = value;
+        else if (option == "--output")
+            outputPath = value;
+        else if (option == "--cache")
+            cachePath = value;
+        else if (option == "--checkpoint")
+            checkpointPath = value;
+        else if (option != "--threads")
+        {
+            printBatchUsage();
+
+            return 2;
+        }
+    }
+
+    std::ifstream jobFile;
+
+    if (jobPath != "-")
+    {
+        jobFile.open(jobPath);
+
+        if (!jobFile)
+        {
+            std::cerr << "Can't read job file " << jobPath << std::endl;
+
+            return 2;
+        }
+    }
+
+    std::ofstream outputFile;
+
+    if (!outputPath.empty())
+    {
+        outputFile.open(outputPath);
+
+        if (!outputFile)
+        {
+            std::cerr << "Can't write to " << outputPath << std::endl;
+
+            return 2;
+        }
+    }
+
+    auto& jobInput{ jobPath == "-" ? std::cin : jobFile };
+    auto& output{ outputPath.empty() ? std::cout : outputFile };
+
+    std::vector<CommandLineJob> jobs;
+    auto lineNumber{ 0 };
+
+    for (std::string line; std::getline(jobInput, line);)
+    {
+        ++lineNumber;
+
+        const auto firstCharacter{ line.find_first_not_of(" \t\r") };
+
+        if (firstCharacter != std::string::npos && line[firstCharacter] != '#')
+            jobs.push_back(parseJob(line, std::to_string(lineNumber)));
+    }
+
+    if (!checkpointPath.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(checkpointPath, error);
+
+        for (auto& job : jobs)
+            job.tuningJob.checkpointPath = std::filesystem::path(checkpointPath) / (job.id + ".checkpoint");
+    }
+
+    ThreadPool threadPool(threadCount);
+
+    std::optional<TuningCache> cache;
+    if (!cachePath.empty())
+        cache.emplace(cachePath);
+
+    TuningSettings settings;
+    settings.threadPool = &threadPool;
+    settings.engine = TuningEngine::logarithmic;
+    settings.silent = true;
+    settings.cache = cache.has_value() ? &cache.value() : nullptr;
+
+    OrderedResultWriter writer(output, jobs.size());
+    std::atomic<size_t> failedJobCount{ 0 };
+
+    //jobs in the same pitch space are tuned as one batch, and every batch runs at once
+    std::map<std::pair<bool, std::string>, std::vector<size_t>> jobIndeciesByPitchSpace;
+    std::vector<size_t> keyboardJobIndecies;
+
+    for (auto jobIndex{ 0 }; jobIndex != jobs.size(); ++jobIndex)
+    {
+        if (jobs[jobIndex].error.empty() && !jobs[jobIndex].keyboardPath.empty())
+            keyboardJobIndecies.push_back(jobIndex);
+        else if (jobs[jobIndex].error.empty())
+            jobIndeciesByPitchSpace[{ jobs[jobIndex].isFractional, jobs[jobIndex].pitchSpaceName }].push_back(jobIndex);
+        else
+        {
+            ++failedJobCount;
+            writer.write(jobIndex, formatJobResult(jobs[jobIndex], std::nullopt));
+        }
+    }
+
+    TaskGroup batches(threadPool);
+
+    for (const auto& [pitchSpace, jobIndecies] : jobIndeciesByPitchSpace)
+        batches.run([&, pitchSpace, jobIndecies]()
+            {
+                if (pitchSpace.first)
+                    runJobsInPitchSpace(PitchSpaces::fractional().at(pitchSpace.second), jobs, jobIndecies, settings, writer,
+                                        failedJobCount);
+                else
+                    runJobsInPitchSpace(PitchSpaces::decimal().at(pitchSpace.second), jobs, jobIndecies, settings, writer,
+                                        failedJobCount);
+            });
+
+    for (const auto& jobIndex : keyboardJobIndecies)
+        batches.run([&, jobIndex]()
+            {
+                const auto& job{ jobs[jobIndex] };
+
+                if (job.isFractional)
+                    runKeyboardJob(PitchSpaces::fractional().at(job.pitchSpaceName), jobs, jobIndex, settings, writer,
+                                   failedJobCount);
+                else
+                    runKeyboardJob(PitchSpaces::decimal().at(job.pitchSpaceName), jobs, jobIndex, settings, writer,
+                                   failedJobCount);
+            });
+
+    batches.wait();
+
+    std::cerr << jobs.size() - failedJobCount << " of " << jobs.size() << " jobs succeeded" << std::endl;
+
+    return failedJobCount == 0 ? 0 : 1;
+}
+
+static void printShardUsage()
+{
+    std::cerr << "Usage: TuningMaker --shard <index>/<count> --job <job file> --output <shard file> [--threads <n>]\n"
+              << "       TuningMaker --merge --job <job file> [--output <file>] <shard file>...\n"
+              << "The first job of the job file, which is read as in batch mode and can't be a keyboard job, is tuned in\n"
+              << "count shards, each of which can be tuned by a different process, and shard index, counted from 0, is\n"
+              << "written to the shard file. --merge combines the shard files of every shard of the job and writes its\n"
+              << "result as a line of JSON, as batch mode does.\n"
+              << "Exits with 0 if the shard or merge succeeded, 1 if it failed, and 2 if the arguments or job file are invalid.\n"
+              << std::flush;
+}
+
+/*
+  Returns the scale job tunes, or std::nullopt if it has no scale.
+*/
+static std::optional<Scale> makeJobScale(const CommandLineJob& job)
+{
+    if (job.isFractional)
+        return PitchSpaces::fractional().at(job.pitchSpaceName).makeScale(job.tuningJob);
+
+    return PitchSpaces::decimal().at(job.pitchSpaceName).makeScale(job.tuningJob);
+}
+
+/*
+  Tunes one shard of a job, or merges the shards of a job, for tuning a job across several processes.
+*/
+static int runShardMode(const int& argc, char* argv[])
+{
+    std::string jobPath, outputPath;
+    std::vector<std::string> shardPaths;
+    auto isMerging{ false };
+    size_t shardIndex{ 0 }, shardCount{ 0 };
+    auto threadCount{ std::max(1u, std::thread::hardware_concurrency()) };
+
+    for (auto argument{ 1 }; argument < argc; ++argument)
+    {
+        const std::string option{ argv[argument] };
+
+        if (option == "--merge")
+        {
+            isMerging = true;
+            continue;
+        }
+
+        if (option.rfind("--", 0) != 0)
+        {
+            shardPaths.push_back(option);
+            continue;
+        }
+
+        if (argument + 1 == argc)
+        {
+            printShardUsage();
+
+            return 2;
+        }
+
+        const std::string value{ argv[++argument] };
+        const auto separatorPosition{ value.find('/') };
+        auto isValid{ true };
+
+        if (option == "--shard")
+            isValid = separatorPosition != std::string::npos
+                && readValue(value.substr(0, separatorPosition), shardIndex)
+                && readValue(value.substr(separatorPosition + 1), shardCount);
+        else if (option == "--job")
+            jobPath = value;
+        else if (option == "--output")
+            outputPath = value;
+        else if (option == "--threads")
+            isValid = readValue(value, threadCount);
+        else
+            isValid = false;
+
+        if (!isValid)
+        {
+            printShardUsage();
+
+            return 2;
+        }
+    }
+
+    if (jobPath.empty() || (isMerging ? shardPaths.empty() || shardCount != 0
+                                      : !shardPaths.empty() || shardIndex >= shardCount || outputPath.empty()))
+    {
+        printShardUsage();
+
+        return 2;
+    }
+
+    std::ifstream jobFile(jobPath);
+    std::optional<CommandLineJob> job;
+    auto lineNumber{ 0 };
+
+    for (std::string line; !job.has_value() && std::getline(jobFile, line);)
+    {
+        ++lineNumber;
+
+        const auto firstCharacter{ line.find_first_not_of(" \t\r") };
+
+        if (firstCharacter != std::string::npos && line[firstCharacter] != '#')
+            job = parseJob(line, std::to_string(lineNumber));
+    }
+
+    if (!job.has_value() || !job->error.empty() || !job->keyboardPath.empty())
+    {
+        std::cerr << "Can't read a job from " << jobPath
+                  << (job.has_value() && !job->error.empty() ? ": " + job->error
+                      : job.has_value() ? ": keyboard jobs can't be sharded" : std::string()) << std::endl;
+
+        return 2;
+    }
+
+    const auto scale{ makeJobScale(job.value()) };
+
+    ThreadPool threadPool(threadCount);
+
+    //the same settings as batch mode, which every shard and the merge must share
+    TuningSettings settings;
+    settings.threadPool = &threadPool;
+    settings.engine = TuningEngine::logarithmic;
+    settings.silent = true;
+    settings.weightCutoff = job->tuningJob.weightCutoff;
+
+    if (!isMerging)
+    {
+        const auto shard{ scale->tuneShard(shardIndex, shardCount, settings) };
+
+        if (!shard.writeFile(outputPath))
+        {
+            std::cerr << "Can't write to " << outputPath << std::endl;
+
+            return 1;
+        }
+
+        std::cerr << "Tuned " << shard.getTunedCount() << " of " << shard.isTuned.size() << " pairs as shard "
+                  << shardIndex << " of " << shardCount << std::endl;
+
+        return 0;
+    }
+
+    std::vector<PartialTunings> shards;
+
+    for (const auto& shardPath : shardPaths)
+    {
+        auto shard{ PartialTunings::readFile(shardPath) };
+
+        if (!shard.has_value())
+        {
+            std::cerr << "Can't read shard " << shardPath << std::endl;
+
+            return 1;
+        }
+
+        shards.push_back(std::move(shard.value()));
+    }
+
+    std::optional<std::vector<double>> tuning;
+
+    if (auto mergedTuning{ scale->mergeShards(shards, job->tuningJob.trueRootNote, settings) }; !mergedTuning.empty())
+        tuning = std::move(mergedTuning);
+    else
+        job->error = "the shards don't cover every pair of the job, or were tuned for a different job";
+
+    std::ofstream outputFile;
+
+    if (!outputPath.empty())
+    {
+        outputFile.open(outputPath);
+
+        if (!outputFile)
+        {
+            std::cerr << "Can't write to " << outputPath << std::endl;
+
+            return 2;
+        }
+    }
+
+    auto& output{ outputPath.empty() ? std::cout : outputFile };
+    output << formatJobResult(job.value(), tuning) << std::flush;
+
+    return tuning.has_value() ? 0 : 1;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-    PitchSpaces::initialisePitchSpaceScales();
+    for (auto argument{ 1 }; argument < argc; ++argument)
+        if (std::string(argv[argument]) == "--shard" || std::string(argv[argument]) == "--merge")
+            return runShardMode(argc, argv);
+
+    if (argc > 1)
+        return runBatchMode(argc, argv);
 
     std::cout << "Welcome to Tuning Maker. To make a tuning of a scale you must first choose the pitch space it occupies. "
         << "Do you want to use a decimal or fractional pitch space? ";
@@ -124,13 +784,13 @@ int main()
         case 'd':
         {
             std::cout << std::endl << "Available pitch spaces: " << std::endl << std::endl;
-            PitchSpaces::printPitchSpaces(PitchSpaces::decimal);
+            PitchSpaces::printPitchSpaces(PitchSpaces::decimal());
             break;
         }
         case 'f':
         {
             std::cout << std::endl << "Available pitch spaces: " << std::endl << std::endl;
-            PitchSpaces::printPitchSpaces(PitchSpaces::fractional);
+            PitchSpaces::printPitchSpaces(PitchSpaces::fractional());
             break;
         }
         default:
@@ -154,7 +814,7 @@ int main()
     switch (pitchSpaceType)
     {
     case 'd':
-        if (PitchSpaces::decimal.find(pitchSpaceName) == PitchSpaces::decimal.end())
+        if (PitchSpaces::decimal().find(pitchSpaceName) == PitchSpaces::decimal().end())
         {
             std::cout << "Enter the intervals in [" << pitchSpaceName << "] as decimals separated by spaces. Enter 'end' when finished." << std::endl << std::endl;
 
@@ -164,7 +824,7 @@ int main()
         }
         break;
 	case 'f':
-        if (PitchSpaces::fractional.find(pitchSpaceName) == PitchSpaces::fractional.end())
+        if (PitchSpaces::fractional().find(pitchSpaceName) == PitchSpaces::fractional().end())
         {
             std::cout << "Enter the intervals in [" << pitchSpaceName << "] as fractions separated by spaces. Enter 'end' when finished." << std::endl << std::endl;
 
@@ -181,11 +841,11 @@ int main()
 
     if (pitchSpaceType == 'd')
     {
-        PitchSpaces::decimal.at(pitchSpaceName).printSigniatures();
+        PitchSpaces::decimal().at(pitchSpaceName).printSigniatures();
     }
     else if (pitchSpaceType == 'f')
     {
-        PitchSpaces::fractional.at(pitchSpaceName).printSigniatures();
+        PitchSpaces::fractional().at(pitchSpaceName).printSigniatures();
 	}
 
     std::cout << "Enter the name of the scale in [" << pitchSpaceName << "] you want to use or enter a new name to create a custom scale: ";
@@ -197,19 +857,19 @@ int main()
     switch (pitchSpaceType)
     {
     case 'd':
-        if (!PitchSpaces::decimal.at(pitchSpaceName).getSigniature(scaleName).has_value())
+        if (!PitchSpaces::decimal().at(pitchSpaceName).getSigniature(scaleName).has_value())
         {
             std::cout << std::endl << "Enter the indecies of the intervals from the [" << scaleName << "] scale as integers separated by spaces. Enter 'end' when finished:" << std::endl << std::endl;
 
-            addCustomScaleToPitchSpace(PitchSpaces::decimal.at(pitchSpaceName), scaleName);
+            addCustomScaleToPitchSpace(PitchSpaces::decimal().at(pitchSpaceName), scaleName);
         }
         break;
     case 'f':
-        if (!PitchSpaces::fractional.at(pitchSpaceName).getSigniature(scaleName).has_value())
+        if (!PitchSpaces::fractional().at(pitchSpaceName).getSigniature(scaleName).has_value())
         {
             std::cout << std::endl << "Enter the indecies of the intervals from the [" << scaleName << "] scale as integers separated by spaces. Enter 'end' when finished:" << std::endl << std::endl;
 
-            addCustomScaleToPitchSpace(PitchSpaces::fractional.at(pitchSpaceName), scaleName);
+            addCustomScaleToPitchSpace(PitchSpaces::fractional().at(pitchSpaceName), scaleName);
         }
         break;
     default:
@@ -224,12 +884,12 @@ int main()
     switch (pitchSpaceType)
     {
     case 'd':
-        PitchSpaces::decimal.at(pitchSpaceName).printSigniature(scaleName);
-        scaleLength = PitchSpaces::decimal.at(pitchSpaceName).getSigniature(scaleName).value().size();
+        PitchSpaces::decimal().at(pitchSpaceName).printSigniature(scaleName);
+        scaleLength = PitchSpaces::decimal().at(pitchSpaceName).getSigniature(scaleName).value().size();
         break;
     case 'f':
-        PitchSpaces::fractional.at(pitchSpaceName).printSigniature(scaleName);
-        scaleLength = PitchSpaces::fractional.at(pitchSpaceName).getSigniature(scaleName).value().size();
+        PitchSpaces::fractional().at(pitchSpaceName).printSigniature(scaleName);
+        scaleLength = PitchSpaces::fractional().at(pitchSpaceName).getSigniature(scaleName).value().size();
         break;
     default:
         break;
@@ -283,19 +943,19 @@ int main()
 
     if (pitchSpaceType == 'd')
     {
-        const auto relationsTable{ PitchSpaces::decimal.at(pitchSpaceName).makeRangedScaleRelations(scaleName, range) };
+        const auto relationsTable{ PitchSpaces::decimal().at(pitchSpaceName).makeRangedScaleRelations(scaleName, range) };
         if (relationsTable.has_value())
         {
             scale = Scale(IntervalPatternMakers::rangedScaleLongDoubleToIntervalsWithUniformWeight(relationsTable.value()),
                           scaleNameFull);
 
             if (wantsDummyNotes == 'y')
-				scale.setDummyIndecies(PitchSpaces::decimal.at(pitchSpaceName).getDummyIndecies(scaleName, range));
+				scale.setDummyIndecies(PitchSpaces::decimal().at(pitchSpaceName).getDummyIndecies(scaleName, range));
         }
     }
     else if (pitchSpaceType == 'f')
     {
-        const auto relationsTable{ PitchSpaces::fractional.at(pitchSpaceName).makeRangedScaleRelations(scaleName, range) };
+        const auto relationsTable{ PitchSpaces::fractional().at(pitchSpaceName).makeRangedScaleRelations(scaleName, range) };
         if (relationsTable.has_value())
         {
             std::cout << std::endl << "Enter the exponent of the Tenney height used to calculate each interval's weight "
@@ -310,24 +970,71 @@ int main()
                           scaleNameFull);
 
             if (wantsDummyNotes == 'y')
-                scale.setDummyIndecies(PitchSpaces::fractional.at(pitchSpaceName).getDummyIndecies(scaleName, range));
+                scale.setDummyIndecies(PitchSpaces::fractional().at(pitchSpaceName).getDummyIndecies(scaleName, range));
         }
     }
 
-	std::cout << std::endl << "Enter the cutoff weight (between 0 and 1) for tuning calculations (hint: smaller values produce more accurate tunings but take longer to compute): ";
+	std::cout << std::endl << "Enter the cutoff weight (between 0 and 1) for tuning calculations (hint: smaller values produce more accurate tunings but take longer to compute), "
+        << "or a number of seconds followed by 's' (e.g. 30s) to use the smallest cutoff predicted to finish in that time, "
+        << "or a number of cents followed by 'c' (e.g. 0.1c) to prune only what can't move any note by more than that: ";
 
-    long double weightLimit;
-	std::cin >> weightLimit;
+    std::string weightLimitAnswer;
+	std::cin >> weightLimitAnswer;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
+    ThreadPool threadPool;
+
+    TuningSettings settings;
+    settings.threadPool = &threadPool;
+    settings.engine = TuningEngine::logarithmic;
+
+    long double weightLimit{ 0 };
+
+    if (!weightLimitAnswer.empty() && weightLimitAnswer.back() == 's')
+    {
+        double budgetSeconds{ 0 };
+        readValue(weightLimitAnswer.substr(0, weightLimitAnswer.size() - 1), budgetSeconds);
+
+        const auto chosenWeightLimit{ scale.chooseWeightCutoff(std::chrono::duration<double>(budgetSeconds), settings) };
+
+        if (chosenWeightLimit.has_value())
+            weightLimit = chosenWeightLimit.value();
+        else
+        {
+            std::cout << std::endl << "No cutoff is predicted to finish in " << budgetSeconds << " seconds, so the largest is used.";
+            weightLimit = 1;
+        }
+
+        std::cout << std::endl << "Using a cutoff weight of " << weightLimit << ".";
+    }
+    else if (!weightLimitAnswer.empty() && weightLimitAnswer.back() == 'c')
+    {
+        readValue(weightLimitAnswer.substr(0, weightLimitAnswer.size() - 1), settings.maxCentsError);
+
+        std::cout << std::endl << "Every note will be within " << settings.maxCentsError << " cents of its exact tuning.";
+    }
+    else
+        readValue(weightLimitAnswer, weightLimit);
+
     if (weightLimit < 0)
 		weightLimit = 0;
 	if (weightLimit > 1)
 		weightLimit = 1;
 
-    std::cout << std::endl;
+    settings.weightCutoff = weightLimit;
+
+    //the estimator predicts traversals pruned by weightCutoff, so says nothing about maxCentsError
+    if (settings.maxCentsError <= 0)
+    {
+        const auto estimate{ scale.estimateRuntime(settings) };
+
+        std::cout << std::endl << "Predicted time: " << std::fixed << std::setprecision(2) << estimate.seconds << " seconds ("
+            << std::setprecision(0) << estimate.nodeCount << " nodes)." << std::defaultfloat;
+    }
+
+    std::cout << std::endl << std::endl;
 
-    const auto tuning{ scale.tuneScale(trueRootNote, weightLimit) };
+    const auto tuning{ scale.tuneScale(trueRootNote, settings) };
 
     std::cout << "Final tuning for " << scaleNameFull << ": " << std::endl;
 
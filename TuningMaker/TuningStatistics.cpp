@@ -0,0 +1,79 @@
+#include "TuningStatistics.h"
+#include <cstdlib>
+#include <new>
+
+void TuningJobStatistics::add(const TuningJobStatistics& otherStatistics)
+{
+    nodesVisited += otherStatistics.nodesVisited;
+    rootLeaves += otherStatistics.rootLeaves;
+    cutLeaves += otherStatistics.cutLeaves;
+    maxDepth = std::max(maxDepth, otherStatistics.maxDepth);
+    powCalls += otherStatistics.powCalls;
+    heapAllocations += otherStatistics.heapAllocations;
+}
+
+void TuningStatistics::aggregate()
+{
+    nodesVisited = rootLeaves = cutLeaves = powCalls = heapAllocations = 0;
+    maxDepthHistogram.clear();
+
+    for (const auto& job : jobs)
+    {
+        nodesVisited += job.nodesVisited;
+        rootLeaves += job.rootLeaves;
+        cutLeaves += job.cutLeaves;
+        powCalls += job.powCalls;
+        heapAllocations += job.heapAllocations;
+
+        //notes tuned against themselves, and pairs skipped after a cancellation, have no depth
+        if (job.nodesVisited == 0)
+            continue;
+
+        if (maxDepthHistogram.size() <= job.maxDepth)
+            maxDepthHistogram.resize(job.maxDepth + 1, 0);
+
+        ++maxDepthHistogram[job.maxDepth];
+    }
+}
+
+#if TUNING_STATISTICS
+/*
+  The global allocation functions are replaced so that allocations made while a thread is counting into a
+  TuningJobStatistics are counted. The nothrow forms call these, and the aligned forms are left alone.
+*/
+void* operator new(std::size_t size)
+{
+    if (auto* statistics{ TuningCounters::currentJob() })
+        ++statistics->heapAllocations;
+
+    if (auto* memory{ std::malloc(size == 0 ? 1 : size) })
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/*
+  Define TUNING_STATISTICS as 1 for every translation unit to have Scale::tuneScale() count what its
+  traversals do. Otherwise every counter is compiled out, and the traversals are exactly as fast as if they
+  had never been counted.
+*/
+#ifndef TUNING_STATISTICS
+#define TUNING_STATISTICS 0
+#endif
+
+static constexpr bool tuningStatisticsEnabled{ TUNING_STATISTICS != 0 };
+
+/*
+  What the traversal of one (rootNote, note) pair did. TuningEngine::exactSubsets tunes every note of a root
+  note at once, so its statistics are of the whole root note and have note -1.
+*/
+struct TuningJobStatistics
+{
+    int rootNote{ 0 };
+    int note{ 0 };
+    /*
+      The nodes of the tree of paths entered, or for TuningEngine::monteCarlo the steps of every sampled
+      path, or for TuningEngine::exactSubsets the entries of the memo table calculated.
+    */
+    uint64_t nodesVisited{ 0 };
+    /*
+      The paths ended by reaching the root note.
+    */
+    uint64_t rootLeaves{ 0 };
+    /*
+      The paths ended by their rolling weight falling to or below the weight cutoff, or with
+      TuningSettings::maxCentsError, by the error of ending them fitting in what remained of the error allowed.
+    */
+    uint64_t cutLeaves{ 0 };
+    /*
+      The depth of the deepest node entered, counted in intervals from the note.
+    */
+    size_t maxDepth{ 0 };
+    /*
+      The calls to std::pow and std::exp2, or the approximations which replace them, made by the traversal.
+    */
+    uint64_t powCalls{ 0 };
+    /*
+      The heap allocations made on the threads tuning the pair while they were tuning it.
+    */
+    uint64_t heapAllocations{ 0 };
+    double wallSeconds{ 0 };
+
+    /*
+      Adds the counts of otherStatistics, the statistics of part of the same traversal, to these.
+    */
+    void add(const TuningJobStatistics& otherStatistics);
+};
+
+/*
+  What the traversals of a scale did while it was tuned by Scale::tuneScale(), both for each traversal and
+  in total. Every count is 0 and collected is false unless TUNING_STATISTICS is defined as 1.
+*/
+struct TuningStatistics
+{
+    bool collected{ false };
+    /*
+      True if the tuning was read from TuningSettings::cache, so that nothing was traversed.
+    */
+    bool fromCache{ false };
+    std::vector<TuningJobStatistics> jobs;
+    uint64_t nodesVisited{ 0 };
+    uint64_t rootLeaves{ 0 };
+    uint64_t cutLeaves{ 0 };
+    uint64_t powCalls{ 0 };
+    uint64_t heapAllocations{ 0 };
+    /*
+      At index depth, the number of traversals whose deepest node was at that depth. Jobs which entered no
+      node, such as a note tuned against itself, are left out.
+    */
+    std::vector<uint64_t> maxDepthHistogram;
+    /*
+      The time taken by the whole of tuneScale(), which is less than the sum of the time taken by each
+      traversal when they are run on a thread pool.
+    */
+    double wallSeconds{ 0 };
+
+    /*
+      Sets the totals from jobs.
+    */
+    void aggregate();
+};
+
+/*
+  The counters which the traversals of Scale increment. Each thread counts into the TuningJobStatistics of
+  the traversal it is running, set by a Scope, and counts nothing outside of one.
+*/
+namespace TuningCounters
+{
+    /*
+      Returns the statistics the calling thread counts into, or nullptr.
+    */
+    inline TuningJobStatistics*& currentJob()
+    {
+        static thread_local TuningJobStatistics* statistics{ nullptr };
+
+        return statistics;
+    }
+
+    /*
+      Makes the calling thread count into statistics for its lifetime, timing it, and then restores whatever
+      the thread counted into before, so that a thread which runs another traversal while waiting on a
+      thread pool counts each into its own statistics.
+    */
+    class Scope
+    {
+    public:
+        Scope(TuningJobStatistics& statistics)
+            : previousStatistics{ currentJob() }
+            , start{ std::chrono::steady_clock::now() }
+        {
+            currentJob() = &statistics;
+        }
+
+        ~Scope()
+        {
+            currentJob()->wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            currentJob() = previousStatistics;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TuningJobStatistics* previousStatistics;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /*
+      Counts a node at depth whose siblings include prunedCount leaves, one of which is the root note if
+      reachesRootNote is true.
+    */
+    inline void countNode(const size_t& depth, const int& prunedCount, const bool& reachesRootNote)
+    {
+        if constexpr (tuningStatisticsEnabled)
+            if (auto* statistics{ currentJob() })
+            {
+                ++statistics->nodesVisited;
+                statistics->rootLeaves += reachesRootNote;
+                statistics->cutLeaves += prunedCount - reachesRootNote;
+                statistics->maxDepth = std::max(statistics->maxDepth, depth);
+            }
+    }
+
+    /*
+      Counts cutCount more leaves ended without reaching the root note by a node already counted.
+    */
+    inline void countCutLeaves(const int& cutCount)
+    {
+        if constexpr (tuningStatisticsEnabled)
+            if (auto* statistics{ currentJob() })
+                statistics->cutLeaves += cutCount;
+    }
+
+    /*
+      Counts powCount calls to std::pow or std::exp2.
+    */
+    inline void countPow(const uint64_t& powCount = 1)
+    {
+        if constexpr (tuningStatisticsEnabled)
+            if (auto* statistics{ currentJob() })
+                statistics->powCalls += powCount;
+    }
+}
\ No newline at end of file
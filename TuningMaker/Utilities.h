@@ -5,6 +5,13 @@
 #include <vector>
 #include <numeric>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
+
+/*
+  The number of notes addressable by MIDI, which is also the largest number of notes a Scale can have.
+*/
+static constexpr size_t maxMidiNotes{ 128 };
 
 /*
   Returns the greatest common denominator of integers a and b, used by Fraction.
@@ -47,6 +54,21 @@ static inline double centsFromRatio(const double& ratio)
     return 1200 * std::log2(ratio);
 }
 
+/*
+  Returns the greatest difference in cents between the notes of two tunings of the same scale, such as
+  tunings made by different engines or in different numeric precisions. Dummy (NaN) notes are ignored.
+*/
+static double maxCentsDifference(const std::vector<double>& tuning, const std::vector<double>& otherTuning)
+{
+    double maxDifference{ 0 };
+
+    for (auto note{ 0 }; note != tuning.size() && note != otherTuning.size(); ++note)
+        if (!std::isnan(tuning[note]) && !std::isnan(otherTuning[note]))
+            maxDifference = std::max(maxDifference, std::abs(centsFromRatio(otherTuning[note] / tuning[note])));
+
+    return maxDifference;
+}
+
 /*
   Returns the frequency (Hz) of a ratio from baseFrequency.
 */
@@ -56,12 +78,13 @@ static inline double frequencyFromRatio(const double& ratio, const double& baseF
 }
 
 /*
-  Enforces value does not exceed it's numeric limits and if it is NaN returns 0.
+  Enforces value does not exceed the numeric limits of Real and if it is NaN returns 0.
 */
-static long double clampLongDoubleToLimits(const long double& value)
+template<typename Real>
+static Real clampToLimits(const Real& value)
 {
-    constexpr long double min{ std::numeric_limits<long double>::min() },
-                          max{ std::numeric_limits<long double>::max() };
+    constexpr Real min{ std::numeric_limits<Real>::min() },
+                   max{ std::numeric_limits<Real>::max() };
 
     if (value < min)
         return min;